@@ -0,0 +1,149 @@
+/*
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Shahriar Rezghi <shahriar25.ss@gmail.com>
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+     list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+     contributors may be used to endorse or promote products derived from
+     this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "corpus.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+uint64_t bytes(const string &value)
+{
+    size_t index = 0;
+    auto size = stoull(value, &index);
+    auto suffix = value.substr(index);
+    if (suffix == "K" || suffix == "KB") return size << 10;
+    if (suffix == "M" || suffix == "MB") return size << 20;
+    if (suffix == "G" || suffix == "GB") return size << 30;
+    if (!suffix.empty())
+    {
+        cerr << "Unknown size suffix " << suffix << "!" << endl;
+        exit(1);
+    }
+    return size;
+}
+
+Corpus::Numbers numbers(const string &value)
+{
+    if (value == "integer") return Corpus::Numbers::Integer;
+    if (value == "real") return Corpus::Numbers::Real;
+    if (value == "mixed") return Corpus::Numbers::Mixed;
+    if (value == "small") return Corpus::Numbers::Small;
+    cerr << "Unknown number distribution " << value << "!" << endl;
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    string output;
+    Corpus::Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--help")
+        {
+            cout << "Usage: " << argv[0] << " [options]" << endl
+                 << "  --seed N          seed of the random generator (default 42)" << endl
+                 << "  --size BYTES      approximate size of the corpus, accepts K, M and G (default 1M)" << endl
+                 << "  --depth N         maximum nesting depth of records (default 8)" << endl
+                 << "  --fanout N        maximum elements of arrays and objects (default 10)" << endl
+                 << "  --nodes N         maximum values in each record (default 1000)" << endl
+                 << "  --length N        maximum length of strings and keys (default 10)" << endl
+                 << "  --escapes P       probability of escaped string characters (default 0.05)" << endl
+                 << "  --numbers NAME    integer, real, mixed or small (default mixed)" << endl
+                 << "  --repetition P    probability of keys taken from a fixed set (default 0.5)" << endl
+                 << "  --keys N          size of the fixed set of keys (default 32)" << endl
+                 << "  --ndjson          write one record per line instead of a top-level array" << endl
+                 << "  --output PATH     write the corpus to path instead of standard output" << endl;
+            return 0;
+        }
+
+        if (arg == "--ndjson")
+        {
+            options.ndjson = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            cerr << "Missing value of " << arg << "!" << endl;
+            return 1;
+        }
+
+        string value = argv[++i];
+        if (arg == "--seed")
+            options.seed = stoull(value);
+        else if (arg == "--size")
+            options.size = bytes(value);
+        else if (arg == "--depth")
+            options.depth = stoull(value);
+        else if (arg == "--fanout")
+            options.fanout = stoull(value);
+        else if (arg == "--nodes")
+            options.nodes = stoull(value);
+        else if (arg == "--length")
+            options.length = stoull(value);
+        else if (arg == "--escapes")
+            options.escapes = stod(value);
+        else if (arg == "--numbers")
+            options.numbers = numbers(value);
+        else if (arg == "--repetition")
+            options.repetition = stod(value);
+        else if (arg == "--keys")
+            options.keys = stoull(value);
+        else if (arg == "--output")
+            output = value;
+        else
+        {
+            cerr << "Unknown option " << arg << "!" << endl;
+            return 1;
+        }
+    }
+
+    Corpus::Generator generator(options);
+    if (output.empty())
+    {
+        generator.write(cout);
+        return cout ? 0 : 1;
+    }
+
+    ofstream stream(output, ios::binary);
+    if (!stream.is_open())
+    {
+        cerr << "Failed to open " << output << "!" << endl;
+        return 1;
+    }
+    generator.write(stream);
+    return stream ? 0 : 1;
+}
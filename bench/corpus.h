@@ -0,0 +1,236 @@
+/*
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Shahriar Rezghi <shahriar25.ss@gmail.com>
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+     list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+     contributors may be used to endorse or promote products derived from
+     this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neyson/neyson.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/// Namespace that contains the generator of synthetic JSON corpora which is used by the benchmarks.
+namespace Corpus
+{
+/// Distribution of the generated numbers.
+enum class Numbers
+{
+    /// Integers in the whole int64 range with a random magnitude.
+    Integer,
+    /// Reals with a random exponent.
+    Real,
+    /// Half integers and half reals.
+    Mixed,
+    /// Integers between 0 and 100.
+    Small,
+};
+
+/// Options that control the shape of the generated corpus.
+struct Options
+{
+    /// Seed of the random generator which makes the corpus reproducible.
+    uint64_t seed = 42;
+
+    /// Approximate number of bytes of the corpus.
+    uint64_t size = 1 << 20;
+
+    /// Maximum nesting depth of each record.
+    size_t depth = 8;
+
+    /// Maximum number of elements of each array and members of each object.
+    size_t fanout = 10;
+
+    /// Maximum number of values in each record.
+    size_t nodes = 1000;
+
+    /// Maximum length of strings and keys.
+    size_t length = 10;
+
+    /// Probability of each string character being one that has to be escaped.
+    double escapes = 0.05;
+
+    /// Distribution of the numbers.
+    Numbers numbers = Numbers::Mixed;
+
+    /// Probability of an object key being taken from a small fixed set of keys.
+    double repetition = 0.5;
+
+    /// Number of keys in the fixed set of keys.
+    size_t keys = 32;
+
+    /// Writes one record per line (NDJSON) instead of a single top-level array.
+    bool ndjson = false;
+};
+
+/// Generator of random values and corpora which is deterministic for a given seed.
+class Generator
+{
+    Options _options;
+    std::mt19937_64 _random;
+    std::vector<std::string> _keys;
+    size_t _count;
+
+    size_t below(size_t size) { return size == 0 ? 0 : size_t(_random() % size); }
+
+    bool chance(double probability) { return std::uniform_real_distribution<double>(0, 1)(_random) < probability; }
+
+    std::string text(bool escapes)
+    {
+        static const char *Escaped[] = {"\"", "\\", "/", "\n", "\t", "\r", "\b", "\f", "\x01", "\x1f", "\xc3\xa9", "\xe2\x98\x86"};
+        std::string text;
+        for (size_t i = 0, size = below(_options.length + 1); i < size; ++i)
+        {
+            if (escapes && chance(_options.escapes))
+                text += Escaped[below(sizeof(Escaped) / sizeof(Escaped[0]))];
+            else
+                text.push_back(char(' ' + 1 + below(94)));
+        }
+        return text;
+    }
+
+    std::string key()
+    {
+        if (!_keys.empty() && chance(_options.repetition)) return _keys[below(_keys.size())];
+        return text(true);
+    }
+
+    Neyson::Value number()
+    {
+        auto numbers = _options.numbers;
+        if (numbers == Numbers::Mixed) numbers = _random() % 2 ? Numbers::Integer : Numbers::Real;
+        if (numbers == Numbers::Small) return Neyson::Integer(below(101));
+        if (numbers == Numbers::Integer) return Neyson::Integer(_random()) >> below(64);
+
+        std::uniform_real_distribution<double> mantissa(-1, 1);
+        std::uniform_int_distribution<int> exponent(-20, 20);
+        return mantissa(_random) * std::pow(10.0, exponent(_random));
+    }
+
+    size_t count()
+    {
+        auto size = std::min(_count, below(_options.fanout + 1));
+        _count -= size;
+        return size;
+    }
+
+    Neyson::Value value(size_t depth)
+    {
+        auto types = depth < _options.depth ? 7 : 5;
+        auto type = Neyson::Type(below(types));
+        if (type == Neyson::Type::Bool) return bool(_random() % 2);
+        if (type == Neyson::Type::Integer || type == Neyson::Type::Real) return number();
+        if (type == Neyson::Type::String) return text(true);
+
+        if (type == Neyson::Type::Array)
+        {
+            Neyson::Array array(count());
+            for (auto &item : array) item = value(depth + 1);
+            return array;
+        }
+
+        if (type == Neyson::Type::Object)
+        {
+            Neyson::Object object;
+            for (size_t i = 0, size = count(); i < size; ++i) object.insert({key(), value(depth + 1)});
+            return object;
+        }
+        return Neyson::Value();
+    }
+
+public:
+    /// Constructor that creates a generator with the given options.
+    Generator(const Options &options) : _options(options), _random(options.seed), _count(0)
+    {
+        for (size_t i = 0; i < options.keys; ++i) _keys.push_back(text(false));
+    }
+
+    /// Returns the options of the generator.
+    const Options &options() const { return _options; }
+
+    /// Generates a random record which is always an array or an object.
+    Neyson::Value record()
+    {
+        _count = _options.nodes;
+        if (_random() % 2)
+        {
+            Neyson::Array array(std::max<size_t>(count(), 1));
+            for (auto &item : array) item = value(1);
+            return array;
+        }
+
+        Neyson::Object object;
+        for (size_t i = 0, size = std::max<size_t>(count(), 1); i < size; ++i) object.insert({key(), value(1)});
+        return object;
+    }
+
+    /// Writes records to the stream until the size of the corpus is reached and returns the number of bytes written.
+    /// Only one record is kept in memory at a time so the corpus can be larger than the memory.
+    uint64_t write(std::ostream &stream)
+    {
+        std::string data;
+        uint64_t bytes = 0;
+        if (!_options.ndjson) stream << '[', ++bytes;
+
+        for (size_t i = 0; bytes < _options.size; ++i)
+        {
+            Neyson::IO::write(record(), data);
+            if (_options.ndjson)
+                stream << data << '\n';
+            else
+                stream << (i == 0 ? "" : ",") << data;
+            bytes += data.size() + 1;
+        }
+
+        if (!_options.ndjson) stream << ']' << '\n', ++bytes;
+        return bytes;
+    }
+
+    /// Generates records until the size of the corpus is reached and returns each of them as a separate document.
+    std::vector<std::string> documents()
+    {
+        std::string data;
+        uint64_t bytes = 0;
+        std::vector<std::string> documents;
+        while (bytes < _options.size)
+        {
+            Neyson::IO::write(record(), data);
+            bytes += data.size();
+            documents.push_back(data);
+        }
+        return documents;
+    }
+};
+}  // namespace Corpus
@@ -0,0 +1,1283 @@
+/*
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Shahriar Rezghi <shahriar25.ss@gmail.com>
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+     list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+     contributors may be used to endorse or promote products derived from
+     this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "corpus.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#define NEYSON_BENCH_TSC
+#endif
+
+using namespace std;
+using namespace Neyson;
+
+namespace Heap
+{
+atomic<bool> Enabled(false);
+atomic<int64_t> Live(0), Peak(0), Count(0);
+atomic<uint64_t> Allocations(0);
+
+int64_t usable(void *ptr)
+{
+#if defined(__GLIBC__)
+    return int64_t(malloc_usable_size(ptr));
+#elif defined(__APPLE__)
+    return int64_t(malloc_size(ptr));
+#else
+    return (void)ptr, 0;
+#endif
+}
+
+bool available()
+{
+#if defined(__GLIBC__) || defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void *allocate(size_t size)
+{
+    auto ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) throw bad_alloc();
+    if (!Enabled.load(memory_order_relaxed)) return ptr;
+
+    Allocations.fetch_add(1, memory_order_relaxed);
+    Count.fetch_add(1, memory_order_relaxed);
+    auto live = Live.fetch_add(usable(ptr), memory_order_relaxed) + usable(ptr);
+    auto peak = Peak.load(memory_order_relaxed);
+    while (live > peak && !Peak.compare_exchange_weak(peak, live, memory_order_relaxed))
+        ;
+    return ptr;
+}
+
+void deallocate(void *ptr)
+{
+    if (ptr == nullptr) return;
+    if (Enabled.load(memory_order_relaxed))
+    {
+        Count.fetch_sub(1, memory_order_relaxed);
+        Live.fetch_sub(usable(ptr), memory_order_relaxed);
+    }
+    free(ptr);
+}
+}  // namespace Heap
+
+void *operator new(size_t size) { return Heap::allocate(size); }
+
+void *operator new[](size_t size) { return Heap::allocate(size); }
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    try
+    {
+        return Heap::allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const nothrow_t &tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void *ptr) noexcept { Heap::deallocate(ptr); }
+
+void operator delete[](void *ptr) noexcept { Heap::deallocate(ptr); }
+
+void operator delete(void *ptr, const nothrow_t &) noexcept { Heap::deallocate(ptr); }
+
+void operator delete[](void *ptr, const nothrow_t &) noexcept { Heap::deallocate(ptr); }
+
+struct Options
+{
+    size_t iterations = 10;
+    size_t warmup = 2;
+    double sample = 0.05;
+    size_t size = 1 << 20;
+    uint64_t seed = 42;
+    vector<string> corpora;
+    vector<string> benchmarks;
+    vector<string> inputs;
+    string mode = "throughput";
+    vector<size_t> threads;
+    double duration = 1;
+    bool perf = false;
+    string baseline;
+    double threshold = 0.1;
+    double alpha = 0.01;
+    string directory;
+    string output;
+};
+
+struct Dataset
+{
+    string name;
+    vector<string> documents;
+    size_t bytes;
+};
+
+bool selected(const vector<string> &list, const string &name)
+{
+    return list.empty() || find(list.begin(), list.end(), name) != list.end();
+}
+
+namespace Generate
+{
+const char *Words[] = {
+    "json", "parser", "value", "array", "object", "string", "number", "fast", "small", "library",
+    "neyson", "write", "read", "stream", "file", "document", "token", "tree", "node", "buffer",
+};
+
+string word(mt19937_64 &random) { return Words[random() % (sizeof(Words) / sizeof(Words[0]))]; }
+
+string sentence(mt19937_64 &random, size_t count)
+{
+    string sentence;
+    for (size_t i = 0; i < count; ++i) sentence += (i == 0 ? "" : " ") + word(random);
+    return sentence;
+}
+
+Value tweet(mt19937_64 &random, Integer id)
+{
+    Array hashtags, urls;
+    for (size_t i = random() % 3; i > 0; --i) hashtags.push_back(Object{{"text", word(random)}, {"indices", Array{1, 9}}});
+    for (size_t i = random() % 2; i > 0; --i) urls.push_back("https://example.com/" + word(random));
+
+    Object user{
+        {"id", Integer(random() % 1000000000)},
+        {"name", sentence(random, 2)},
+        {"screen_name", word(random) + to_string(random() % 1000)},
+        {"location", sentence(random, 1 + random() % 3)},
+        {"description", sentence(random, 5 + random() % 15)},
+        {"followers_count", Integer(random() % 100000)},
+        {"friends_count", Integer(random() % 1000)},
+        {"verified", bool(random() % 2)},
+        {"created_at", "Wed Oct 10 20:19:24 +0000 2018"},
+    };
+    return Object{
+        {"id", id},
+        {"id_str", to_string(id)},
+        {"created_at", "Thu Apr 06 15:24:15 +0000 2017"},
+        {"text", sentence(random, 5 + random() % 20)},
+        {"user", move(user)},
+        {"entities", Object{{"hashtags", move(hashtags)}, {"urls", move(urls)}}},
+        {"retweet_count", Integer(random() % 1000)},
+        {"favorite_count", Integer(random() % 1000)},
+        {"favorited", false},
+        {"coordinates", Value()},
+        {"lang", "en"},
+    };
+}
+
+Value numbers(mt19937_64 &random)
+{
+    Array array;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        if (random() % 2)
+            array.push_back(Array{Real(random() % 36000000) / 100000 - 180, Real(random() % 18000000) / 100000 - 90});
+        else
+            array.push_back(Integer(random()) >> (random() % 64));
+    }
+    return array;
+}
+
+Value nested(mt19937_64 &random, size_t depth)
+{
+    if (depth == 0) return Integer(random() % 100);
+    if (depth % 2 == 0) return Array{nested(random, depth - 1), Integer(depth)};
+    return Object{{word(random), nested(random, depth - 1)}, {"depth", Integer(depth)}};
+}
+
+Value escaped(mt19937_64 &random)
+{
+    const char *pieces[] = {"\"", "\\", "/", "\n", "\t", "\r", "\b", "\f", "\x01", "\xe2\x98\x86", "\xc3\xa9"};
+    string string;
+    for (size_t i = 0, size = 16 + random() % 64; i < size; ++i)
+        string += random() % 4 ? word(random) : pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+    return string;
+}
+
+Value tiny(mt19937_64 &random, Integer id)
+{
+    return Object{{"id", id}, {"type", word(random)}, {"ok", bool(random() % 2)}, {"score", Real(random() % 1000) / 10}};
+}
+
+string text(const Value &value)
+{
+    string data;
+    IO::write(value, data);
+    return data;
+}
+
+Dataset single(const string &name, size_t size, const function<Value()> &item)
+{
+    Array array;
+    size_t bytes = 2;
+    while (bytes < size)
+    {
+        array.push_back(item());
+        bytes += text(array.back()).size() + 1;
+    }
+    auto data = text(array);
+    return Dataset{name, {data}, data.size()};
+}
+
+Dataset load(const string &path)
+{
+    ifstream stream(path, ios::binary);
+    if (!stream.is_open())
+    {
+        cerr << "Failed to open " << path << "!" << endl;
+        exit(1);
+    }
+
+    Dataset dataset{path, {}, 0};
+    auto extension = path.substr(path.find_last_of('.') + 1);
+    if (extension == "ndjson" || extension == "jsonl")
+    {
+        for (string line; getline(stream, line);)
+            if (!line.empty()) dataset.documents.push_back(line);
+    }
+    else
+        dataset.documents.push_back(string(istreambuf_iterator<char>(stream), {}));
+
+    for (const auto &document : dataset.documents) dataset.bytes += document.size();
+    return dataset;
+}
+
+vector<Dataset> corpora(const Options &options)
+{
+    mt19937_64 random(options.seed);
+    Integer id = 0;
+    vector<Dataset> corpora;
+    corpora.push_back(single("tweets", options.size, [&]() { return tweet(random, ++id); }));
+    corpora.push_back(single("numbers", options.size, [&]() { return numbers(random); }));
+    corpora.push_back(single("nested", options.size, [&]() { return nested(random, 64); }));
+    corpora.push_back(single("strings", options.size, [&]() { return escaped(random); }));
+
+    Dataset tiny{"tiny", {}, 0};
+    while (tiny.bytes < options.size)
+    {
+        tiny.documents.push_back(text(Generate::tiny(random, ++id)));
+        tiny.bytes += tiny.documents.back().size();
+    }
+    corpora.push_back(move(tiny));
+
+    Corpus::Options generated;
+    generated.seed = options.seed;
+    generated.size = options.size;
+    Dataset records{"records", Corpus::Generator(generated).documents(), 0};
+    for (const auto &document : records.documents) records.bytes += document.size();
+    corpora.push_back(move(records));
+
+    for (const auto &path : options.inputs) corpora.push_back(load(path));
+    return corpora;
+}
+}  // namespace Generate
+
+namespace Perf
+{
+struct Event
+{
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+#if defined(__linux__)
+const uint64_t L1Miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+const Event Events[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"branchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"l1Misses", PERF_TYPE_HW_CACHE, L1Miss},
+    {"llcMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"taskClock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+};
+#endif
+
+class Counters
+{
+    vector<pair<string, int>> fds;
+    Object errors;
+
+public:
+    Counters()
+    {
+#if defined(__linux__)
+        for (const auto &event : Events)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = event.type;
+            attr.config = event.config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            auto fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd >= 0)
+                fds.emplace_back(event.name, fd);
+            else
+                errors[event.name] = strerror(errno);
+        }
+#endif
+    }
+
+    ~Counters()
+    {
+#if defined(__linux__)
+        for (const auto &pair : fds) close(pair.second);
+#endif
+    }
+
+    Counters(const Counters &) = delete;
+    Counters &operator=(const Counters &) = delete;
+
+    void start()
+    {
+#if defined(__linux__)
+        for (const auto &pair : fds)
+        {
+            ioctl(pair.second, PERF_EVENT_IOC_RESET, 0);
+            ioctl(pair.second, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    Value stop(uint64_t bytes)
+    {
+        Object counters;
+#if defined(__linux__)
+        for (const auto &pair : fds) ioctl(pair.second, PERF_EVENT_IOC_DISABLE, 0);
+        for (const auto &pair : fds)
+        {
+            uint64_t data[3] = {0, 0, 0};
+            if (read(pair.second, data, sizeof(data)) != sizeof(data) || data[2] == 0) continue;
+            // Scales the count when the kernel multiplexed the counter with others.
+            counters[pair.first] = Integer(double(data[0]) * data[1] / data[2]);
+        }
+#else
+        errors["all"] = "perf_event_open is only available on Linux";
+#endif
+
+        Value result = Object{{"available", counters.count("cycles") != 0}};
+        auto perByte = [&](const char *name, const char *key) {
+            if (counters.count(name) && bytes != 0) result[key] = counters[name].integer() / double(bytes);
+        };
+        perByte("cycles", "cyclesPerByte");
+        perByte("instructions", "instructionsPerByte");
+        if (counters.count("cycles") && counters.count("instructions") && counters["cycles"].integer() != 0)
+            result["ipc"] = counters["instructions"].integer() / double(counters["cycles"].integer());
+        result["counters"] = move(counters);
+        if (!errors.empty()) result["errors"] = errors;
+        return result;
+    }
+};
+}  // namespace Perf
+
+namespace Bench
+{
+double seconds(const function<void()> &function)
+{
+    auto start = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void check(const Result &result, const string &what)
+{
+    if (result) return;
+    cerr << what << " failed with " << result << "!" << endl;
+    exit(1);
+}
+
+Value summarize(const Dataset &corpus, vector<double> times, size_t batch)
+{
+    sort(times.begin(), times.end());
+    double mean = 0, deviation = 0;
+    for (auto time : times) mean += time / times.size();
+    for (auto time : times) deviation += (time - mean) * (time - mean) / times.size();
+
+    Array samples;
+    auto median = times[times.size() / 2];
+    for (auto time : times) samples.push_back(time);
+    return Object{
+        {"bytes", corpus.bytes},
+        {"documents", corpus.documents.size()},
+        {"iterations", times.size()},
+        {"batch", batch},
+        {"median", median},
+        {"mean", mean},
+        {"min", times.front()},
+        {"max", times.back()},
+        {"stddev", sqrt(deviation)},
+        {"mbps", corpus.bytes / median / 1e6},
+        {"dps", corpus.documents.size() / median},
+        {"samples", move(samples)},
+    };
+}
+
+Value run(const Dataset &corpus, const string &benchmark, const Options &options)
+{
+    vector<Value> values(corpus.documents.size());
+    vector<string> outputs(corpus.documents.size());
+    vector<string> paths(corpus.documents.size());
+    for (size_t i = 0; i < corpus.documents.size(); ++i)
+    {
+        check(IO::read(values[i], corpus.documents[i]), corpus.name);
+        paths[i] = options.directory + "/neyson_bench_" + to_string(i) + ".json";
+    }
+
+    function<void()> function;
+    if (benchmark == "parse")
+        function = [&]() {
+            for (size_t i = 0; i < values.size(); ++i) check(IO::read(values[i], corpus.documents[i]), "parse");
+        };
+    else if (benchmark == "write")
+        function = [&]() {
+            for (size_t i = 0; i < values.size(); ++i) check(IO::write(values[i], outputs[i]), "write");
+        };
+    else if (benchmark == "fread")
+    {
+        for (size_t i = 0; i < values.size(); ++i) check(IO::fwrite(values[i], paths[i]), "fwrite");
+        function = [&]() {
+            for (size_t i = 0; i < values.size(); ++i) check(IO::fread(values[i], paths[i]), "fread");
+        };
+    }
+    else if (benchmark == "fwrite")
+        function = [&]() {
+            for (size_t i = 0; i < values.size(); ++i) check(IO::fwrite(values[i], paths[i]), "fwrite");
+        };
+    else
+    {
+        cerr << "Unknown benchmark " << benchmark << "!" << endl;
+        exit(1);
+    }
+
+    for (size_t i = 0; i < options.warmup; ++i) function();
+
+    // Each sample repeats the function until it lasts at least --sample seconds so that the timer resolution and
+    // scheduler noise stay small compared to the measured time, and reports the time of a single repetition.
+    auto once = max(seconds(function), 1e-9);
+    auto batch = max<size_t>(size_t(ceil(options.sample / once)), 1);
+    auto repeated = [&]() {
+        for (size_t i = 0; i < batch; ++i) function();
+    };
+
+    unique_ptr<Perf::Counters> counters(options.perf ? new Perf::Counters() : nullptr);
+    if (counters) counters->start();
+    vector<double> times;
+    for (size_t i = 0; i < options.iterations; ++i) times.push_back(seconds(repeated) / batch);
+    auto perf = counters ? counters->stop(corpus.bytes * options.iterations * batch) : Value();
+    if (benchmark == "fread" || benchmark == "fwrite")
+        for (const auto &path : paths) remove(path.c_str());
+
+    auto summary = summarize(corpus, times, batch);
+    if (counters) summary["perf"] = move(perf);
+    return summary;
+}
+}  // namespace Bench
+
+namespace Footprint
+{
+int64_t rss()
+{
+#if defined(__linux__)
+    long pages = 0, resident = 0;
+    auto file = fopen("/proc/self/statm", "r");
+    if (file == nullptr) return -1;
+    auto count = fscanf(file, "%ld %ld", &pages, &resident);
+    fclose(file);
+    return count == 2 ? int64_t(resident) * sysconf(_SC_PAGESIZE) : -1;
+#else
+    return -1;
+#endif
+}
+
+// Returns free heap pages to the kernel and resets the peak resident set size of the process to the current one, so
+// that the peak read afterwards belongs to what runs in between. Returns false if the kernel doesn't allow it.
+bool reset()
+{
+#if defined(__linux__)
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+    auto file = fopen("/proc/self/clear_refs", "w");
+    if (file == nullptr) return false;
+    auto written = fputs("5", file) >= 0;
+    return fclose(file) == 0 && written;
+#else
+    return false;
+#endif
+}
+
+int64_t peak()
+{
+#if defined(__linux__)
+    auto file = fopen("/proc/self/status", "r");
+    if (file == nullptr) return -1;
+    long peak = -1;
+    char line[256];
+    while (peak < 0 && fgets(line, sizeof(line), file) != nullptr)
+        if (sscanf(line, "VmHWM: %ld kB", &peak) != 1) peak = -1;
+    fclose(file);
+    return peak < 0 ? -1 : int64_t(peak) * 1024;
+#else
+    return -1;
+#endif
+}
+
+Value sizes()
+{
+    return Object{
+        {"Value", sizeof(Value)},
+        {"String", sizeof(String)},
+        {"Array", sizeof(Array)},
+        {"Object", sizeof(Object)},
+        // Estimate of a node of the hash table which has the pair, the next pointer and the cached hash.
+        {"ObjectNode", sizeof(Object::value_type) + sizeof(void *) + sizeof(size_t)},
+    };
+}
+
+Value run(const Dataset &corpus)
+{
+    Heap::Enabled = true;
+    vector<Value> values(corpus.documents.size());
+    auto rss = Footprint::reset() ? Footprint::rss() : -1;
+    auto live = Heap::Live.load(), count = Heap::Count.load();
+    auto allocations = Heap::Allocations.load();
+    Heap::Peak = live;
+
+    Stats total{};
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        Stats stats;
+        Bench::check(IO::read(values[i], corpus.documents[i], &stats), corpus.name);
+        for (size_t j = 0; j < 7; ++j) total.values[j] += stats.values[j];
+        total.allocations += stats.allocations;
+    }
+
+    auto heap = Heap::Live.load() - live;
+    auto peak = Heap::Peak.load() - live;
+    auto maximum = rss < 0 ? -1 : Footprint::peak();
+    auto input = Real(corpus.bytes);
+    size_t nodes = 0;
+    for (auto count : total.values) nodes += count;
+
+    Value result = Object{
+        {"input", corpus.bytes},
+        {"nodes", nodes},
+        {"payloads", total.allocations},
+        {"strings", total.values[int(Type::String)]},
+        {"arrays", total.values[int(Type::Array)]},
+        {"objects", total.values[int(Type::Object)]},
+        {"peakRss", maximum < 0 ? Value() : Value(maximum - rss)},
+        {"peakRssPerInput", maximum < 0 ? Value() : Value((maximum - rss) / input)},
+    };
+
+    if (Heap::available())
+    {
+        result["heap"] = heap;
+        result["heapPerInput"] = heap / input;
+        result["bytesPerNode"] = heap / Real(max<size_t>(nodes, 1));
+        result["allocations"] = Heap::Allocations.load() - allocations;
+        result["retained"] = Heap::Count.load() - count;
+        result["peak"] = peak;
+        result["peakPerInput"] = peak / input;
+    }
+
+    values.clear();
+    Heap::Enabled = false;
+    return result;
+}
+}  // namespace Footprint
+
+namespace Scaling
+{
+struct Counter
+{
+    uint64_t documents = 0;
+    uint64_t bytes = 0;
+};
+
+vector<string> documents(mt19937_64 &random, size_t count, size_t tweets)
+{
+    Integer id = 0;
+    vector<string> documents;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Array array;
+        for (size_t j = 0; j < tweets; ++j) array.push_back(Generate::tweet(random, ++id));
+        documents.push_back(Generate::text(tweets == 1 ? array[0] : Value(array)));
+    }
+    return documents;
+}
+
+Value measure(const vector<string> &documents, size_t threads, double duration)
+{
+    atomic<bool> stop(false);
+    atomic<size_t> ready(0);
+    vector<Counter> counters(threads);
+    vector<thread> workers;
+
+    for (size_t i = 0; i < threads; ++i)
+        workers.emplace_back([&, i]() {
+            Value value;
+            string output;
+            Counter counter;
+            ++ready;
+            while (ready.load() != threads) this_thread::yield();
+
+            for (size_t j = i; !stop.load(memory_order_relaxed); ++j)
+            {
+                const auto &document = documents[j % documents.size()];
+                Bench::check(IO::read(value, document), "parse");
+                Bench::check(IO::write(value, output), "write");
+                ++counter.documents;
+                counter.bytes += document.size();
+            }
+            counters[i] = counter;
+        });
+
+    while (ready.load() != threads) this_thread::yield();
+    auto start = chrono::steady_clock::now();
+    this_thread::sleep_for(chrono::duration<double>(duration));
+    stop = true;
+    for (auto &worker : workers) worker.join();
+    auto seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t total = 0, bytes = 0;
+    Array perThread;
+    for (const auto &counter : counters)
+    {
+        total += counter.documents;
+        bytes += counter.bytes;
+        perThread.push_back(counter.documents / seconds);
+    }
+
+    return Object{
+        {"threads", threads},
+        {"seconds", seconds},
+        {"dps", total / seconds},
+        {"mbps", bytes / seconds / 1e6},
+        {"dpsPerThread", total / seconds / threads},
+        {"threadDps", move(perThread)},
+    };
+}
+
+Value run(const Options &options)
+{
+    mt19937_64 random(options.seed);
+    auto threads = options.threads;
+    if (threads.empty())
+        for (size_t count = 1; count <= max<size_t>(thread::hardware_concurrency(), 1); count *= 2)
+            threads.push_back(count);
+
+    Object results;
+    vector<pair<string, vector<string>>> sets = {
+        {"small", documents(random, 256, 1)},
+        {"medium", documents(random, 16, 40)},
+    };
+
+    for (const auto &set : sets)
+    {
+        if (!selected(options.corpora, set.first)) continue;
+        Array rows;
+        Real single = 0;
+        for (auto count : threads)
+        {
+            cerr << "Running " << count << " threads on " << set.first << "..." << endl;
+            auto row = measure(set.second, count, options.duration);
+            if (count == threads.front()) single = row["dpsPerThread"].real();
+            row["efficiency"] = single == 0 ? 0 : row["dpsPerThread"].real() / single;
+            rows.push_back(move(row));
+        }
+
+        size_t bytes = 0;
+        for (const auto &document : set.second) bytes += document.size();
+        results[set.first] = Object{{"documentBytes", bytes / set.second.size()}, {"runs", move(rows)}};
+    }
+    return results;
+}
+}  // namespace Scaling
+
+namespace Latency
+{
+#ifdef NEYSON_BENCH_TSC
+const bool Tsc = true;
+inline uint64_t ticks() { return __rdtsc(); }
+#else
+const bool Tsc = false;
+inline uint64_t ticks() { return chrono::steady_clock::now().time_since_epoch().count(); }
+#endif
+
+double calibrate()
+{
+#ifdef NEYSON_BENCH_TSC
+    auto start = chrono::steady_clock::now();
+    auto first = ticks();
+    this_thread::sleep_for(chrono::milliseconds(50));
+    auto last = ticks();
+    auto nanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return nanoseconds / (last - first);
+#else
+    return double(chrono::steady_clock::period::num) * 1e9 / chrono::steady_clock::period::den;
+#endif
+}
+
+vector<string> documents(mt19937_64 &random, size_t count)
+{
+    Integer id = 0;
+    vector<string> documents;
+    while (documents.size() < count)
+    {
+        Value value;
+        auto kind = random() % 4;
+        if (kind == 0)
+            value = Generate::numbers(random);
+        else if (kind == 1)
+            value = Generate::tweet(random, ++id);
+        else
+        {
+            Array array;
+            for (size_t i = 1 + random() % 8; i > 0; --i) array.push_back(Generate::tiny(random, ++id));
+            value = move(array);
+        }
+
+        auto text = Generate::text(value);
+        if (text.size() >= 200 && text.size() <= 2000) documents.push_back(move(text));
+    }
+    return documents;
+}
+
+Value summarize(const Metrics::Histogram &histogram, uint64_t maximum)
+{
+    return Object{
+        {"samples", histogram.count},
+        {"mean", histogram.mean()},
+        {"p50", histogram.quantile(0.5)},
+        {"p90", histogram.quantile(0.9)},
+        {"p99", histogram.quantile(0.99)},
+        {"p999", histogram.quantile(0.999)},
+        {"max", maximum},
+    };
+}
+
+Value run(const Options &options)
+{
+    mt19937_64 random(options.seed);
+    auto documents = Latency::documents(random, 4096);
+    auto scale = calibrate();
+
+    uint64_t overhead = ~uint64_t(0);
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        auto start = ticks();
+        overhead = min(overhead, ticks() - start);
+    }
+
+    Value value;
+    string output;
+    uint64_t bytes = 0, maxRead = 0, maxWrite = 0;
+    Metrics::Histogram reads, writes;
+    for (size_t i = 0; i < options.warmup + options.iterations; ++i)
+        for (const auto &document : documents)
+        {
+            auto start = ticks();
+            auto result = IO::read(value, document);
+            auto middle = ticks();
+            IO::write(value, output);
+            auto end = ticks();
+            Bench::check(result, "parse");
+            if (i < options.warmup) continue;
+
+            auto read = uint64_t((middle - start) * scale), write = uint64_t((end - middle) * scale);
+            reads.record(read), writes.record(write);
+            maxRead = max(maxRead, read), maxWrite = max(maxWrite, write);
+            bytes += document.size();
+        }
+
+    return Object{
+        {"documents", documents.size()},
+        {"meanBytes", reads.count == 0 ? 0 : bytes / reads.count},
+        {"clock", Object{{"tsc", Tsc}, {"nsPerTick", scale}, {"overhead", overhead * scale}}},
+        {"read", summarize(reads, maxRead)},
+        {"write", summarize(writes, maxWrite)},
+    };
+}
+}  // namespace Latency
+
+namespace Micro
+{
+template <typename T>
+inline void keep(T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static const void *volatile sink;
+    sink = &value;
+#endif
+}
+
+template <typename F>
+Value measure(const Options &options, F function)
+{
+    const size_t Operations = 100000;
+    vector<double> times;
+    for (size_t i = 0; i < options.warmup + options.iterations; ++i)
+    {
+        auto time = Bench::seconds([&]() {
+            for (size_t j = 0; j < Operations; ++j) function();
+        });
+        if (i >= options.warmup) times.push_back(time * 1e9 / Operations);
+    }
+
+    sort(times.begin(), times.end());
+    return Object{{"ns", times[times.size() / 2]}, {"min", times.front()}, {"max", times.back()}};
+}
+
+Value run(const Options &options)
+{
+    Object results;
+    auto add = [&](const string &name, const function<Value()> &function) {
+        if (!selected(options.benchmarks, name)) return;
+        cerr << "Running " << name << "..." << endl;
+        results[name] = function();
+    };
+
+    const String text = "value", longText(64, 'x');
+    Array array;
+    Object object;
+    for (Integer i = 0; i < 16; ++i) array.push_back(i), object["key" + to_string(i)] = i;
+    const Value integer = Integer(42), real = Real(4.2), boolean = true, string = text, arrays = array,
+                objects = object;
+    const std::string key = "key7";
+
+    add("construct/null", [&]() { return measure(options, [&]() { Value value; keep(value); }); });
+    add("construct/bool", [&]() { return measure(options, [&]() { Value value(true); keep(value); }); });
+    add("construct/integer", [&]() { return measure(options, [&]() { Value value(Integer(42)); keep(value); }); });
+    add("construct/real", [&]() { return measure(options, [&]() { Value value(Real(4.2)); keep(value); }); });
+    add("construct/literal", [&]() { return measure(options, [&]() { Value value("value"); keep(value); }); });
+    add("construct/string", [&]() { return measure(options, [&]() { Value value(longText); keep(value); }); });
+    add("construct/array", [&]() { return measure(options, [&]() { Value value(array); keep(value); }); });
+    add("construct/object", [&]() { return measure(options, [&]() { Value value(object); keep(value); }); });
+
+    add("copy/integer", [&]() { return measure(options, [&]() { Value value(integer); keep(value); }); });
+    add("copy/string", [&]() { return measure(options, [&]() { Value value(string); keep(value); }); });
+    add("copy/array", [&]() { return measure(options, [&]() { Value value(arrays); keep(value); }); });
+    add("copy/object", [&]() { return measure(options, [&]() { Value value(objects); keep(value); }); });
+    add("move/string", [&]() {
+        Value source = text;
+        return measure(options, [&]() {
+            Value value(move(source));
+            keep(value);
+            source = move(value);
+        });
+    });
+    add("move/object", [&]() {
+        Value source = object;
+        return measure(options, [&]() {
+            Value value(move(source));
+            keep(value);
+            source = move(value);
+        });
+    });
+
+    add("lookup/char", [&]() {
+        Value value = object;
+        return measure(options, [&]() { keep(value["key7"]); });
+    });
+    add("lookup/string", [&]() {
+        Value value = object;
+        return measure(options, [&]() { keep(value[key]); });
+    });
+    add("lookup/const-char", [&]() { return measure(options, [&]() { keep(objects["key7"]); }); });
+    add("lookup/const-string", [&]() { return measure(options, [&]() { keep(objects[key]); }); });
+    add("lookup/index", [&]() { return measure(options, [&]() { keep(arrays[7]); }); });
+
+    add("access/boolean", [&]() { return measure(options, [&]() { keep(boolean.boolean()); }); });
+    add("access/integer", [&]() { return measure(options, [&]() { keep(integer.integer()); }); });
+    add("access/real", [&]() { return measure(options, [&]() { keep(real.real()); }); });
+    add("access/string", [&]() { return measure(options, [&]() { keep(string.string()); }); });
+    add("access/array", [&]() { return measure(options, [&]() { keep(arrays.array()); }); });
+    add("access/object", [&]() { return measure(options, [&]() { keep(objects.object()); }); });
+
+    add("convert/bool", [&]() {
+        return measure(options, [&]() {
+            bool value = integer;
+            keep(value);
+        });
+    });
+    add("convert/integer", [&]() {
+        return measure(options, [&]() {
+            Integer value = real;
+            keep(value);
+        });
+    });
+    add("convert/real", [&]() {
+        return measure(options, [&]() {
+            Real value = integer;
+            keep(value);
+        });
+    });
+    add("convert/string", [&]() {
+        return measure(options, [&]() {
+            String value = string;
+            keep(value);
+        });
+    });
+
+    add("reset/integer", [&]() {
+        Value value;
+        return measure(options, [&]() {
+            value = Integer(42);
+            value.reset();
+            keep(value);
+        });
+    });
+    add("reset/string", [&]() {
+        Value value;
+        return measure(options, [&]() {
+            value = text;
+            value.reset();
+            keep(value);
+        });
+    });
+    return results;
+}
+}  // namespace Micro
+
+namespace Gate
+{
+// Fewer samples make the test significant on a couple of outliers, so such comparisons are reported but never fail.
+const size_t MinSamples = 20;
+
+vector<double> samples(const Value &value)
+{
+    vector<double> samples;
+    for (const auto &sample : value["samples"].array()) samples.push_back(Real(sample));
+    return samples;
+}
+
+double median(vector<double> samples)
+{
+    sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// One sided Mann-Whitney U test with the normal approximation and tie correction, returns the probability of
+// observing times at least this much slower than the baseline when both come from the same distribution.
+double mannWhitney(const vector<double> &current, const vector<double> &baseline)
+{
+    vector<pair<double, bool>> all;
+    for (auto time : current) all.emplace_back(time, true);
+    for (auto time : baseline) all.emplace_back(time, false);
+    sort(all.begin(), all.end());
+
+    double n1 = current.size(), n2 = baseline.size(), n = n1 + n2;
+    double ranks = 0, ties = 0;
+    for (size_t i = 0, j = 0; i < all.size(); i = j)
+    {
+        while (j < all.size() && all[j].first == all[i].first) ++j;
+        double count = j - i, rank = (i + 1 + j) / 2.0;
+        for (auto k = i; k < j; ++k) ranks += all[k].second ? rank : 0;
+        ties += count * count * count - count;
+    }
+
+    double u = ranks - n1 * (n1 + 1) / 2;
+    double sigma = sqrt(n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1))));
+    if (sigma == 0) return 0.5;
+    auto z = (u - n1 * n2 / 2 - 0.5) / sigma;
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+Value compare(const Value &report, const Value &baseline, const Options &options, size_t &regressions)
+{
+    for (const char *key : {"size", "seed"})
+        if (Integer(report[key]) != Integer(baseline[key]))
+            cerr << "Warning: " << key << " of the baseline is " << Integer(baseline[key]) << " but "
+                 << Integer(report[key]) << " was used!" << endl;
+
+    Object gate;
+    regressions = 0;
+    fprintf(stderr, "%-12s %-8s %12s %12s %9s %9s  %s\n", "corpus", "bench", "baseline", "current", "change",
+            "p", "verdict");
+    vector<string> corpora;
+    for (const auto &pair : report["results"].object()) corpora.push_back(pair.first);
+    sort(corpora.begin(), corpora.end());
+
+    for (const auto &corpus : corpora)
+    {
+        if (!baseline["results"].object().count(corpus)) continue;
+        const auto &current = report["results"][corpus], &previous = baseline["results"][corpus];
+        for (const char *benchmark : {"parse", "write"})
+        {
+            if (!current.object().count(benchmark) || !previous.object().count(benchmark)) continue;
+            auto now = samples(current[benchmark]), before = samples(previous[benchmark]);
+            if (now.empty() || before.empty()) continue;
+
+            auto change = median(now) / median(before) - 1;
+            auto p = mannWhitney(now, before);
+            auto enough = now.size() >= MinSamples && before.size() >= MinSamples;
+            auto regressed = enough && change > options.threshold && p < options.alpha;
+            regressions += regressed;
+
+            fprintf(stderr, "%-12s %-8s %10.3fms %10.3fms %+8.1f%% %9.4f  %s\n", corpus.c_str(), benchmark,
+                    median(before) * 1e3, median(now) * 1e3, change * 100, p,
+                    !enough ? "too few samples"
+                            : (regressed ? "REGRESSED" : (change < -options.threshold ? "improved" : "ok")));
+            gate[corpus + "/" + benchmark] = Object{
+                {"baseline", median(before)},
+                {"current", median(now)},
+                {"change", change},
+                {"p", p},
+                {"samples", min(now.size(), before.size())},
+                {"regressed", regressed},
+            };
+        }
+    }
+    return Object{
+        {"baseline", options.baseline},
+        {"threshold", options.threshold},
+        {"alpha", options.alpha},
+        {"regressions", regressions},
+        {"comparisons", move(gate)},
+    };
+}
+}  // namespace Gate
+
+Options parse(int argc, char **argv)
+{
+    Options options;
+    auto directory = getenv("TMPDIR");
+    options.directory = directory ? directory : ".";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--help")
+        {
+            cout << "Usage: " << argv[0] << " [options]" << endl
+                 << "  --mode NAME      throughput, memory, scaling, latency or micro (default throughput)" << endl
+                 << "  --iterations N   measured iterations (default 10)" << endl
+                 << "  --warmup N       warm-up iterations (default 2)" << endl
+                 << "  --sample SEC     minimum seconds of each measured iteration, repeating short ones (default 0.05)"
+                 << endl
+                 << "  --size BYTES     size of each corpus (default 1048576)" << endl
+                 << "  --seed N         seed of the corpus generator (default 42)" << endl
+                 << "  --corpus NAME    tweets, numbers, nested, strings, tiny or records (repeatable)" << endl
+                 << "  --input PATH     also benchmark the file at path, one document per line for .ndjson and .jsonl"
+                 << endl
+                 << "  --bench NAME     parse, write, fread, fwrite or a micro benchmark such as lookup/char (repeatable)" << endl
+                 << "  --threads LIST   comma separated thread counts of scaling (default powers of two up to cores)"
+                 << endl
+                 << "  --duration SEC   seconds of each scaling run (default 1)" << endl
+                 << "  --perf           hardware counters per benchmark with perf_event_open (Linux)" << endl
+                 << "  --baseline PATH  compare parse and write with a previous report and fail on regressions" << endl
+                 << "  --threshold R    relative slowdown of the median that counts as a regression (default 0.1)"
+                 << endl
+                 << "  --alpha P        significance level of the Mann-Whitney test (default 0.01)" << endl
+                 << "  --directory DIR  directory of temporary files (default $TMPDIR or .)" << endl
+                 << "  --output PATH    write the JSON report to path instead of standard output" << endl;
+            exit(0);
+        }
+        if (arg == "--perf")
+        {
+            options.perf = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            cerr << "Missing value of " << arg << "!" << endl;
+            exit(1);
+        }
+
+        string value = argv[++i];
+        if (arg == "--mode")
+            options.mode = value;
+        else if (arg == "--iterations")
+            options.iterations = max<size_t>(stoull(value), 1);
+        else if (arg == "--warmup")
+            options.warmup = stoull(value);
+        else if (arg == "--sample")
+            options.sample = stod(value);
+        else if (arg == "--size")
+            options.size = stoull(value);
+        else if (arg == "--seed")
+            options.seed = stoull(value);
+        else if (arg == "--corpus")
+            options.corpora.push_back(value);
+        else if (arg == "--bench")
+            options.benchmarks.push_back(value);
+        else if (arg == "--input")
+            options.inputs.push_back(value);
+        else if (arg == "--threads")
+        {
+            stringstream stream(value);
+            for (string count; getline(stream, count, ',');) options.threads.push_back(max<size_t>(stoull(count), 1));
+        }
+        else if (arg == "--duration")
+            options.duration = stod(value);
+        else if (arg == "--baseline")
+            options.baseline = value;
+        else if (arg == "--threshold")
+            options.threshold = stod(value);
+        else if (arg == "--alpha")
+            options.alpha = stod(value);
+        else if (arg == "--directory")
+            options.directory = value;
+        else if (arg == "--output")
+            options.output = value;
+        else
+        {
+            cerr << "Unknown option " << arg << "!" << endl;
+            exit(1);
+        }
+    }
+    return options;
+}
+
+int main(int argc, char **argv)
+{
+    auto options = parse(argc, argv);
+    const char *benchmarks[] = {"parse", "write", "fread", "fwrite"};
+    const char *modes[] = {"throughput", "memory", "scaling", "latency", "micro"};
+    if (find(begin(modes), end(modes), options.mode) == end(modes))
+    {
+        cerr << "Unknown mode " << options.mode << "!" << endl;
+        return 1;
+    }
+
+    Object results;
+    auto standalone = options.mode == "scaling" || options.mode == "latency" || options.mode == "micro";
+    auto corpora = standalone ? vector<Dataset>() : Generate::corpora(options);
+    if (options.mode == "scaling") results = Scaling::run(options).object();
+    if (options.mode == "latency") results = Latency::run(options).object();
+    if (options.mode == "micro") results = Micro::run(options).object();
+    for (const auto &corpus : corpora)
+    {
+        auto input = find(options.inputs.begin(), options.inputs.end(), corpus.name) != options.inputs.end();
+        if (!input && !selected(options.corpora, corpus.name)) continue;
+        if (options.mode == "memory")
+        {
+            cerr << "Measuring memory of " << corpus.name << "..." << endl;
+            results[corpus.name] = Footprint::run(corpus);
+            continue;
+        }
+
+        Object result;
+        for (auto benchmark : benchmarks)
+        {
+            if (!selected(options.benchmarks, benchmark)) continue;
+            cerr << "Running " << benchmark << " on " << corpus.name << "..." << endl;
+            result[benchmark] = Bench::run(corpus, benchmark, options);
+        }
+        results[corpus.name] = move(result);
+    }
+
+    ostringstream simd;
+    simd << Simd::level();
+    Value report = Object{
+        {"version", to_string(NEYSON_VERSION_MAJOR) + "." + to_string(NEYSON_VERSION_MINOR) + "." +
+                        to_string(NEYSON_VERSION_PATCH)},
+        {"mode", options.mode},
+        {"simd", simd.str()},
+        {"iterations", options.iterations},
+        {"warmup", options.warmup},
+        {"size", options.size},
+        {"seed", options.seed},
+        {"results", move(results)},
+    };
+    if (options.mode == "memory") report["sizes"] = Footprint::sizes();
+
+    size_t regressions = 0;
+    if (!options.baseline.empty())
+    {
+        Value baseline;
+        Bench::check(IO::fread(baseline, options.baseline), "baseline " + options.baseline);
+        if (options.mode != "throughput" || baseline["mode"] != Type::String || String(baseline["mode"]) != "throughput")
+        {
+            cerr << "Baseline comparison needs throughput reports!" << endl;
+            return 1;
+        }
+        report["gate"] = Gate::compare(report, baseline, options, regressions);
+    }
+
+    if (options.output.empty())
+    {
+        Bench::check(IO::write(report, &cout, Mode::Readable), "report");
+        cout << endl;
+    }
+    else
+        Bench::check(IO::fwrite(report, options.output, Mode::Readable), "report");
+
+    if (regressions != 0) cerr << regressions << " benchmarks regressed against " << options.baseline << "!" << endl;
+    return regressions == 0 ? 0 : 2;
+}
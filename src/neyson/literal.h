@@ -0,0 +1,498 @@
+/*
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Shahriar Rezghi <shahriar25.ss@gmail.com>
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+     list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+     contributors may be used to endorse or promote products derived from
+     this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neyson/neyson.h>
+
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+namespace Neyson
+{
+/// Namespace that contains the compile-time JSON literals of C++20. A literal such as R"({"a": [1, 2]})"_json is
+/// parsed and validated by the compiler into a frozen tape of nodes that lives in read-only data, so constant
+/// documents need neither a parse nor allocations at startup. Invalid literals fail to compile.
+namespace Literal
+{
+/// Node of the tape, containers are followed by their elements and objects by key and value pairs.
+struct Node
+{
+    /// Type of the node.
+    Type type = Type::Null;
+
+    /// Number of elements of arrays, members of objects or characters of strings.
+    uint32_t size = 0;
+
+    /// Index of the node after this one and all of its children.
+    uint32_t next = 0;
+
+    /// Offset of the characters of strings.
+    uint32_t offset = 0;
+
+    /// Value of bool and integer nodes.
+    Integer integer = 0;
+
+    /// Value of real nodes.
+    Real real = 0;
+};
+
+namespace Detail
+{
+// Not constexpr on purpose, calling it while parsing a literal stops the compilation with the message.
+inline void invalid(const char *message)
+{
+#ifdef NEYSON_NO_EXCEPTIONS
+    (void)message;
+    std::abort();
+#else
+    throw std::runtime_error(message);
+#endif
+}
+
+template <size_t N>
+struct Fixed
+{
+    char data[N];
+
+    constexpr Fixed(const char (&str)[N])
+    {
+        for (size_t i = 0; i < N; ++i) data[i] = str[i];
+    }
+};
+
+struct Parser
+{
+    const char *ptr, *end;
+    Node *nodes;
+    char *chars;
+    uint32_t count = 0, length = 0;
+
+    constexpr void skip()
+    {
+        while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n')) ++ptr;
+    }
+
+    constexpr void expect(char chr, const char *message)
+    {
+        if (ptr == end || *ptr != chr) invalid(message);
+        ++ptr;
+    }
+
+    constexpr uint32_t node(Type type)
+    {
+        if (nodes) nodes[count].type = type;
+        return count++;
+    }
+
+    constexpr void put(uint32_t code)
+    {
+        char bytes[4] = {char(code), 0, 0, 0};
+        uint32_t size = 1;
+        if (code > 0x7F && code <= 0x07FF)
+        {
+            bytes[0] = char(((code >> 6) & 0x1F) | 0xC0), bytes[1] = char((code & 0x3F) | 0x80);
+            size = 2;
+        }
+        else if (code > 0x07FF && code <= 0xFFFF)
+        {
+            bytes[0] = char(((code >> 12) & 0x0F) | 0xE0), bytes[1] = char(((code >> 6) & 0x3F) | 0x80);
+            bytes[2] = char((code & 0x3F) | 0x80);
+            size = 3;
+        }
+        for (uint32_t i = 0; i < size; ++i, ++length)
+            if (chars) chars[length] = bytes[i];
+    }
+
+    constexpr void string()
+    {
+        auto index = node(Type::String);
+        auto offset = length;
+        expect('\"', "Expected the opening quote of a string!");
+        while (true)
+        {
+            if (ptr == end) invalid("Expected the closing quote of a string!");
+            auto chr = *ptr++;
+            if (chr == '\"') break;
+            if (uint8_t(chr) < 0x20) invalid("Control characters must be escaped in strings!");
+            if (chr != '\\')
+            {
+                if (chars) chars[length] = chr;
+                ++length;
+                continue;
+            }
+
+            if (ptr == end) invalid("Expected an escape sequence!");
+            chr = *ptr++;
+            if (chr == '\"' || chr == '\\' || chr == '/')
+                put(uint32_t(chr));
+            else if (chr == 'b')
+                put('\b');
+            else if (chr == 'f')
+                put('\f');
+            else if (chr == 'n')
+                put('\n');
+            else if (chr == 'r')
+                put('\r');
+            else if (chr == 't')
+                put('\t');
+            else if (chr == 'u')
+            {
+                uint32_t code = 0;
+                for (int i = 0; i < 4; ++i, ++ptr)
+                {
+                    if (ptr == end) invalid("Expected four hex digits after \\u!");
+                    code <<= 4;
+                    if (*ptr >= '0' && *ptr <= '9')
+                        code += uint32_t(*ptr - '0');
+                    else if (*ptr >= 'a' && *ptr <= 'f')
+                        code += uint32_t(*ptr - 'a' + 10);
+                    else if (*ptr >= 'A' && *ptr <= 'F')
+                        code += uint32_t(*ptr - 'A' + 10);
+                    else
+                        invalid("Expected four hex digits after \\u!");
+                }
+                put(code);
+            }
+            else
+                invalid("Unknown escape sequence!");
+        }
+
+        if (nodes) nodes[index].size = length - offset, nodes[index].offset = offset;
+    }
+
+    constexpr void number()
+    {
+        auto index = node(Type::Integer);
+        bool negative = ptr < end && *ptr == '-', real = false, overflow = false;
+        if (negative) ++ptr;
+        if (ptr == end || *ptr < '0' || *ptr > '9') invalid("Expected a digit!");
+        if (*ptr == '0' && ptr + 1 < end && ptr[1] >= '0' && ptr[1] <= '9') invalid("Leading zeros aren't allowed!");
+
+        uint64_t mantissa = 0;
+        int exponent = 0, digits = 0;
+        auto digit = [&](bool fraction) {
+            auto value = uint64_t(*ptr++ - '0');
+            if (digits < 19)
+                mantissa = mantissa * 10 + value, exponent -= fraction, digits += mantissa != 0;
+            else
+                exponent += !fraction, overflow = true;
+        };
+
+        while (ptr < end && *ptr >= '0' && *ptr <= '9') digit(false);
+        if (ptr < end && *ptr == '.')
+        {
+            real = true, ++ptr;
+            if (ptr == end || *ptr < '0' || *ptr > '9') invalid("Expected a digit after the decimal point!");
+            while (ptr < end && *ptr >= '0' && *ptr <= '9') digit(true);
+        }
+        if (ptr < end && (*ptr == 'e' || *ptr == 'E'))
+        {
+            real = true, ++ptr;
+            bool minus = ptr < end && *ptr == '-';
+            if (ptr < end && (*ptr == '-' || *ptr == '+')) ++ptr;
+            if (ptr == end || *ptr < '0' || *ptr > '9') invalid("Expected a digit in the exponent!");
+            int value = 0;
+            while (ptr < end && *ptr >= '0' && *ptr <= '9')
+                value = value < 100000 ? value * 10 + (*ptr++ - '0') : (++ptr, value);
+            exponent += minus ? -value : value;
+        }
+
+        if (!real)
+        {
+            auto limit = uint64_t(INT64_MAX) + negative;
+            if (overflow || exponent != 0 || mantissa > limit) invalid("Integer is out of range!");
+            if (nodes) nodes[index].integer = negative ? Integer(0 - mantissa) : Integer(mantissa);
+            return;
+        }
+
+        // Computed in long double so the result is exact or within an ulp of strtod for all but extreme inputs.
+        long double value = mantissa, power = 1, base = 10;
+        if (mantissa == 0 || exponent < -400) exponent = 0, value = 0;
+        if (exponent > 330) invalid("Real is out of range!");
+        if (exponent < -300) value /= 1e300L, exponent += 300;
+        for (auto n = uint32_t(exponent < 0 ? -exponent : exponent); n != 0; n >>= 1)
+        {
+            if (n & 1) power *= base;
+            if (n > 1) base *= base;
+        }
+        value = exponent < 0 ? value / power : value * power;
+        if (value > std::numeric_limits<Real>::max()) invalid("Real is out of range!");
+        if (nodes) nodes[index].type = Type::Real, nodes[index].real = Real(negative ? -value : value);
+    }
+
+    constexpr void literal(const char *word, Type type, bool value)
+    {
+        auto index = node(type);
+        for (; *word != '\0'; ++word) expect(*word, "Unexpected start of a value!");
+        if (nodes) nodes[index].integer = value;
+    }
+
+    constexpr void value(size_t depth)
+    {
+        if (depth > 512) invalid("Literal is nested too deeply!");
+        skip();
+        if (ptr == end) invalid("Expected a value!");
+
+        uint32_t index = count, size = 0;
+        if (*ptr == '{' || *ptr == '[')
+        {
+            auto object = *ptr == '{';
+            auto close = object ? '}' : ']';
+            node(object ? Type::Object : Type::Array), ++ptr, skip();
+            if (ptr < end && *ptr == close)
+                ++ptr;
+            else
+                while (true)
+                {
+                    if (object)
+                    {
+                        skip(), string(), skip();
+                        expect(':', "Expected a colon!");
+                    }
+                    value(depth + 1), skip(), ++size;
+                    if (ptr < end && *ptr == close)
+                    {
+                        ++ptr;
+                        break;
+                    }
+                    expect(',', "Expected a comma!");
+                }
+        }
+        else if (*ptr == '\"')
+            string();
+        else if (*ptr == '-' || (*ptr >= '0' && *ptr <= '9'))
+            number();
+        else if (*ptr == 't')
+            literal("true", Type::Bool, true);
+        else if (*ptr == 'f')
+            literal("false", Type::Bool, false);
+        else if (*ptr == 'n')
+            literal("null", Type::Null, false);
+        else
+            invalid("Unexpected start of a value!");
+
+        if (!nodes) return;
+        if (nodes[index].type == Type::Array || nodes[index].type == Type::Object) nodes[index].size = size;
+        nodes[index].next = count;
+    }
+
+    constexpr void parse()
+    {
+        value(0), skip();
+        if (ptr != end) invalid("Unexpected characters after the value!");
+    }
+};
+
+struct Counts
+{
+    uint32_t nodes, chars;
+};
+
+constexpr Counts count(const char *data, size_t size)
+{
+    Parser parser{data, data + size, nullptr, nullptr};
+    parser.parse();
+    return Counts{parser.count, parser.length};
+}
+}  // namespace Detail
+
+/// Read-only view of a node of a frozen document which can be used in constant expressions.
+class View
+{
+    const Node *_nodes;
+    const char *_chars;
+    uint32_t _index;
+
+    constexpr const Node &node(Type type) const
+    {
+        if (_nodes[_index].type != type) Detail::invalid("Literal has another type than the requested one!");
+        return _nodes[_index];
+    }
+
+    constexpr const Node &container() const
+    {
+        auto type = _nodes[_index].type;
+        if (type != Type::Array && type != Type::Object) Detail::invalid("Literal is not an array or object!");
+        return _nodes[_index];
+    }
+
+    constexpr uint32_t child(size_t index) const
+    {
+        if (index >= container().size) Detail::invalid("Index is out of range!");
+        auto child = _index + 1;
+        auto object = _nodes[_index].type == Type::Object;
+        for (size_t i = 0; i < index; ++i) child = _nodes[child + object].next;
+        return child;
+    }
+
+    // Works with indices since some compilers don't fold pointer comparisons when sanitizers are enabled.
+    constexpr uint32_t lookup(std::string_view name) const
+    {
+        auto size = node(Type::Object).size;
+        for (uint32_t i = 0, child = _index + 1; i < size; ++i, child = _nodes[child + 1].next)
+            if (View(_nodes, _chars, child).string() == name) return child + 1;
+        return 0;
+    }
+
+public:
+    /// Constructor that views the node at index of the nodes whose strings are in chars.
+    constexpr View(const Node *nodes, const char *chars, uint32_t index) : _nodes(nodes), _chars(chars), _index(index)
+    {
+    }
+
+    /// Getter function for type of the node.
+    constexpr Type type() const { return _nodes[_index].type; }
+
+    /// Comparison operator that returns true if the type is the same as type arguement otherwise false.
+    constexpr bool operator==(Type type) const { return this->type() == type; }
+
+    /// Getter function of bool nodes.
+    constexpr bool boolean() const { return node(Type::Bool).integer != 0; }
+
+    /// Getter function of integer nodes.
+    constexpr Integer integer() const { return node(Type::Integer).integer; }
+
+    /// Getter function of real nodes.
+    constexpr Real real() const { return node(Type::Real).real; }
+
+    /// Getter function of string nodes.
+    constexpr std::string_view string() const
+    {
+        const auto &node = this->node(Type::String);
+        return std::string_view(_chars + node.offset, node.size);
+    }
+
+    /// Returns the number of elements of arrays or members of objects.
+    constexpr size_t size() const { return container().size; }
+
+    /// Returns the element of arrays or the value of the member of objects at index.
+    constexpr View operator[](size_t index) const
+    {
+        auto child = this->child(index);
+        return View(_nodes, _chars, child + (type() == Type::Object));
+    }
+
+    /// Returns the key of the member of objects at index.
+    constexpr std::string_view key(size_t index) const
+    {
+        if (type() != Type::Object) Detail::invalid("Literal is not an object!");
+        return View(_nodes, _chars, child(index)).string();
+    }
+
+    /// Returns the value of the member of objects with the key or an empty optional if there is none.
+    constexpr std::optional<View> find(std::string_view name) const
+    {
+        auto index = lookup(name);
+        if (index == 0) return std::nullopt;
+        return View(_nodes, _chars, index);
+    }
+
+    /// Returns the value of the member of objects with the key.
+    constexpr View operator[](std::string_view name) const
+    {
+        auto index = lookup(name);
+        if (index == 0) Detail::invalid("Literal object doesn't have the key!");
+        return View(_nodes, _chars, index);
+    }
+
+    /// Converts the node and its children to a Value which allocates like any other value.
+    Value value() const
+    {
+        auto type = this->type();
+        if (type == Type::Bool) return boolean();
+        if (type == Type::Integer) return integer();
+        if (type == Type::Real) return real();
+        if (type == Type::String) return String(string());
+        if (type == Type::Array)
+        {
+            Array array;
+            array.reserve(size());
+            for (uint32_t i = 0, child = _index + 1; i < size(); ++i, child = _nodes[child].next)
+                array.push_back(View(_nodes, _chars, child).value());
+            return array;
+        }
+        if (type == Type::Object)
+        {
+            Object object;
+            object.reserve(size());
+            for (uint32_t i = 0, child = _index + 1; i < size(); ++i, child = _nodes[child + 1].next)
+                object.emplace(View(_nodes, _chars, child).string(), View(_nodes, _chars, child + 1).value());
+            return object;
+        }
+        return Value();
+    }
+};
+
+/// Frozen document with N nodes and C characters of strings.
+template <size_t N, size_t C>
+struct Document
+{
+    /// Nodes of the document in depth-first order.
+    Node nodes[N];
+
+    /// Characters of the strings of the document.
+    char chars[C == 0 ? 1 : C];
+
+    /// Returns the view of the root node.
+    constexpr View root() const { return View(nodes, chars, 0); }
+};
+
+/// Parses the literal into a frozen document at compile time.
+template <Detail::Fixed S>
+constexpr auto freeze()
+{
+    constexpr auto counts = Detail::count(S.data, sizeof(S.data) - 1);
+    Document<counts.nodes, counts.chars> document{};
+    Detail::Parser parser{S.data, S.data + sizeof(S.data) - 1, document.nodes, document.chars};
+    parser.parse();
+    return document;
+}
+
+/// Frozen document of the literal with static storage.
+template <Detail::Fixed S>
+inline constexpr auto Frozen = freeze<S>();
+
+/// User-defined literal that returns the view of the root of the frozen document of the literal.
+template <Detail::Fixed S>
+constexpr View operator""_json()
+{
+    return Frozen<S>.root();
+}
+}  // namespace Literal
+}  // namespace Neyson
+#else
+#error "neyson/literal.h requires C++20"
+#endif
@@ -32,16 +32,35 @@
 
 #include "neyson.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <limits>
+#include <mutex>
+#include <new>
 #include <sstream>
+#include <thread>
 
-#define Skip(ret)                                \
-    parser.ptr += strspn(parser.ptr, " \t\r\n"); \
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NEYSON_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#define Skip(ret)                                  \
+    parser.ptr = parser.simd->whitespace(parser.ptr); \
     if (parser.ptr[0] == '\0') return ret;
 
 #define See(str)                            \
@@ -52,68 +71,59 @@
     if ((parser.ptr++)[0] != chr) return ret;
 
 #define Assert(expr, msg) \
-    if (!static_cast<bool>(expr)) throw std::runtime_error(std::string("") + msg);
+    if (!static_cast<bool>(expr)) fail(std::string("") + msg);
+
+#define Keep(C, ...) C(__VA_ARGS__)
+
+#define Make(C, ...) create<C>(__VA_ARGS__)
 
-#define Construct(C, T, N, A, F, P)     \
-    Value::Value(C &&val)               \
-    {                                   \
-        _type = Type::T;                \
-        _value.N = A C(std::move(val)); \
-    }                                   \
-    Value::Value(const C &val)          \
-    {                                   \
-        _type = Type::T;                \
-        _value.N = A C(val);            \
+#define Construct(C, T, N, A, F, P)       \
+    Value::Value(C &&val)                 \
+    {                                     \
+        _type = Type::T;                  \
+        _value.N = A(C, std::move(val));  \
+    }                                     \
+    Value::Value(const C &val)            \
+    {                                     \
+        _type = Type::T;                  \
+        _value.N = A(C, val);             \
     }
 
 #define Assign(C, T, N, A, F, P)          \
     Value &Value::operator=(C &&val)      \
     {                                     \
         reset();                          \
+        _value.N = A(C, std::move(val));  \
         _type = Type::T;                  \
-        _value.N = A C(std::move(val));   \
         return *this;                     \
     }                                     \
     Value &Value::operator=(const C &val) \
     {                                     \
         reset();                          \
+        _value.N = A(C, val);             \
         _type = Type::T;                  \
-        _value.N = A C(val);              \
         return *this;                     \
     }
 
-#define Return(C, T, N, A, F, P)                                                                               \
-    C &Value::F(C &&val)                                                                                       \
-    {                                                                                                          \
-        reset();                                                                                               \
-        *this = std::move(val);                                                                                \
-        return F();                                                                                            \
-    }                                                                                                          \
-    C &Value::F(const C &val)                                                                                  \
-    {                                                                                                          \
-        reset();                                                                                               \
-        *this = val;                                                                                           \
-        return F();                                                                                            \
-    }                                                                                                          \
-                                                                                                               \
-    C &Value::F()                                                                                              \
-    {                                                                                                          \
-        Assert(_type == Type::T, "Value has type " + TypeName[int(_type)] + " but you requested " + #T + "!"); \
-        return P _value.N;                                                                                     \
-    }                                                                                                          \
-    const C &Value::F() const                                                                                  \
-    {                                                                                                          \
-        Assert(_type == Type::T, "Value has type " + TypeName[int(_type)] + " but you requested " + #T + "!"); \
-        return P _value.N;                                                                                     \
-    }
-
-#define Function(F)                      \
-    F(bool, Bool, b, , boolean, )        \
-    F(Integer, Integer, i, , integer, )  \
-    F(Real, Real, r, , real, )           \
-    F(String, String, s, new, string, *) \
-    F(Array, Array, a, new, array, *)    \
-    F(Object, Object, o, new, object, *)
+#define Return(C, T, N, A, F, P) \
+    C &Value::F(C &&val)         \
+    {                            \
+        *this = std::move(val);  \
+        return P _value.N;       \
+    }                            \
+    C &Value::F(const C &val)    \
+    {                            \
+        *this = val;             \
+        return P _value.N;       \
+    }
+
+#define Function(F)                          \
+    F(bool, Bool, b, Keep, boolean, )        \
+    F(Integer, Integer, i, Keep, integer, )  \
+    F(Real, Real, r, Keep, real, )           \
+    F(String, String, s, Make, string, *)    \
+    F(Array, Array, a, Make, array, *)       \
+    F(Object, Object, o, Make, object, *)
 
 namespace Neyson
 {
@@ -122,67 +132,676 @@ const char *TypeName[] = {
     "Null", "Bool", "Integer", "Real", "String", "Array", "Object",
 };
 
+[[noreturn]] void fail(const std::string &message)
+{
+#ifdef NEYSON_NO_EXCEPTIONS
+    fprintf(stderr, "Neyson: %s\n", message.c_str());
+    std::abort();
+#else
+    throw std::runtime_error(message);
+#endif
+}
+
+namespace Simd
+{
+struct Kernels
+{
+    Level level;
+    const char *(*whitespace)(const char *ptr);
+    const char *(*string)(const char *ptr);
+    const char *(*escape)(const char *ptr);
+    const char *(*number)(const char *ptr);
+    size_t (*ascii)(const char *data, size_t size);
+};
+
+namespace Scalar
+{
+const char *whitespace(const char *ptr) { return ptr + strspn(ptr, " \t\r\n"); }
+
+const char *string(const char *ptr) { return ptr + strcspn(ptr, "\"\\"); }
+
+const char *escape(const char *ptr)
+{
+    while (uint8_t(*ptr) >= 0x20 && uint8_t(*ptr) < 0x80 && *ptr != '\"' && *ptr != '\\' && *ptr != '/') ++ptr;
+    return ptr;
+}
+
+const char *number(const char *ptr) { return ptr + strspn(ptr, "-+.eE0123456789"); }
+
+size_t ascii(const char *data, size_t size)
+{
+    size_t i = 0;
+    while (i < size && uint8_t(data[i]) < 0x80) ++i;
+    return i;
+}
+
+const Kernels Table = {Level::Scalar, whitespace, string, escape, number, ascii};
+}  // namespace Scalar
+
+#ifdef NEYSON_X86
+// The kernels load aligned blocks so they never cross a page and can safely read past the null terminator
+// within the block of the terminator, which is why they are excluded from address, thread and memory sanitizing.
+#define Inline __attribute__((target(Isa), always_inline)) inline
+#define Target __attribute__((target(Isa)))
+#if defined(__clang__)
+#define NoSanitize __attribute__((no_sanitize("address", "thread", "memory")))
+#else
+#define NoSanitize __attribute__((no_sanitize_address, no_sanitize_thread))
+#endif
+
+#define Find(N, P)                                                \
+    Target NoSanitize const char *N(const char *ptr)              \
+    {                                                             \
+        auto offset = size_t(uintptr_t(ptr) % Width);             \
+        auto block = ptr - offset;                                \
+        auto mask = P(load(block)) >> offset;                     \
+        if (mask != 0) return ptr + __builtin_ctzll(mask);        \
+        while (true)                                              \
+        {                                                         \
+            block += Width;                                       \
+            mask = P(load(block));                                \
+            if (mask != 0) return block + __builtin_ctzll(mask);  \
+        }                                                         \
+    }
+
+#define Vectorized(L)                                                                                        \
+    Inline uint64_t spaces(Vector v) { return ~(eq(v, ' ') | eq(v, '\t') | eq(v, '\r') | eq(v, '\n')) & Full; } \
+    Inline uint64_t quotes(Vector v) { return eq(v, '\"') | eq(v, '\\') | eq(v, '\0'); }                        \
+    Inline uint64_t escapes(Vector v)                                                                         \
+    {                                                                                                         \
+        return eq(v, '\"') | eq(v, '\\') | eq(v, '/') | below(v, 0x20) | (~below(v, 0x80) & Full);             \
+    }                                                                                                         \
+    Inline uint64_t digits(Vector v)                                                                          \
+    {                                                                                                         \
+        auto digit = below(v, '9' + 1) & ~below(v, '0');                                                     \
+        return ~(digit | eq(v, '-') | eq(v, '+') | eq(v, '.') | eq(v, 'e') | eq(v, 'E')) & Full;             \
+    }                                                                                                         \
+    Find(whitespace, spaces) Find(string, quotes) Find(escape, escapes) Find(number, digits)                  \
+                                                                                                              \
+    Target size_t ascii(const char *data, size_t size)                                                        \
+    {                                                                                                         \
+        size_t i = 0;                                                                                         \
+        for (; i + Width <= size; i += Width)                                                                 \
+        {                                                                                                     \
+            auto mask = ~below(loadu(data + i), 0x80) & Full;                                                 \
+            if (mask != 0) return i + __builtin_ctzll(mask);                                                  \
+        }                                                                                                     \
+        return i + Scalar::ascii(data + i, size - i);                                                         \
+    }                                                                                                         \
+                                                                                                              \
+    const Kernels Table = {Level::L, whitespace, string, escape, number, ascii};
+
+namespace SSE42
+{
+#define Isa "sse4.2"
+typedef __m128i Vector;
+const size_t Width = 16;
+const uint64_t Full = 0xFFFF;
+
+Inline Vector load(const char *ptr) { return _mm_load_si128(reinterpret_cast<const Vector *>(ptr)); }
+
+Inline Vector loadu(const char *ptr) { return _mm_loadu_si128(reinterpret_cast<const Vector *>(ptr)); }
+
+Inline uint64_t eq(Vector v, char c) { return uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)))); }
+
+Inline uint64_t below(Vector v, uint8_t c)
+{
+    return uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(char(c - 1))), v)));
+}
+
+Vectorized(SSE42)
+#undef Isa
+}  // namespace SSE42
+
+namespace AVX2
+{
+#define Isa "avx2"
+typedef __m256i Vector;
+const size_t Width = 32;
+const uint64_t Full = 0xFFFFFFFF;
+
+Inline Vector load(const char *ptr) { return _mm256_load_si256(reinterpret_cast<const Vector *>(ptr)); }
+
+Inline Vector loadu(const char *ptr) { return _mm256_loadu_si256(reinterpret_cast<const Vector *>(ptr)); }
+
+Inline uint64_t eq(Vector v, char c)
+{
+    return uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+}
+
+Inline uint64_t below(Vector v, uint8_t c)
+{
+    return uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(char(c - 1))), v)));
+}
+
+Vectorized(AVX2)
+#undef Isa
+}  // namespace AVX2
+
+namespace AVX512
+{
+#define Isa "avx512f,avx512bw"
+typedef __m512i Vector;
+const size_t Width = 64;
+const uint64_t Full = ~uint64_t(0);
+
+Inline Vector load(const char *ptr) { return _mm512_load_si512(ptr); }
+
+Inline Vector loadu(const char *ptr) { return _mm512_loadu_si512(ptr); }
+
+Inline uint64_t eq(Vector v, char c) { return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(c)); }
+
+Inline uint64_t below(Vector v, uint8_t c) { return _mm512_cmplt_epu8_mask(v, _mm512_set1_epi8(char(c))); }
+
+Vectorized(AVX512)
+#undef Isa
+}  // namespace AVX512
+
+#undef Vectorized
+#undef Find
+#undef NoSanitize
+#undef Target
+#undef Inline
+#endif
+
+std::atomic<const Kernels *> Active(nullptr);
+
+Level detect()
+{
+#ifdef NEYSON_X86
+    unsigned a, b, c, d, low, high;
+    if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_SSE4_2)) return Level::Scalar;
+    if (!(c & bit_OSXSAVE) || !(c & bit_AVX)) return Level::SSE42;
+
+    // The operating system has to save the vector registers on context switches for them to be usable.
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    if ((low & 0x6) != 0x6 || !__get_cpuid_count(7, 0, &a, &b, &c, &d) || !(b & bit_AVX2)) return Level::SSE42;
+    if ((low & 0xE0) != 0xE0 || !(b & bit_AVX512F) || !(b & bit_AVX512BW)) return Level::AVX2;
+    return Level::AVX512;
+#else
+    return Level::Scalar;
+#endif
+}
+
+const Kernels *table(Level level)
+{
+#ifdef NEYSON_X86
+    if (level == Level::AVX512) return &AVX512::Table;
+    if (level == Level::AVX2) return &AVX2::Table;
+    if (level == Level::SSE42) return &SSE42::Table;
+#endif
+    return &Scalar::Table;
+}
+
+Level supported()
+{
+    static const Level level = detect();
+    return level;
+}
+
+const Kernels *kernels()
+{
+    auto active = Active.load(std::memory_order_acquire);
+    if (active != nullptr) return active;
+
+    auto level = supported();
+    auto name = getenv("NEYSON_SIMD");
+    const char *names[] = {"scalar", "sse4.2", "avx2", "avx512"};
+    for (int i = 0; name != nullptr && i < 4; ++i)
+        if (strcmp(name, names[i]) == 0) level = std::min(level, Level(i));
+
+    const Kernels *expected = nullptr;
+    Active.compare_exchange_strong(expected, table(level), std::memory_order_acq_rel);
+    return Active.load(std::memory_order_acquire);
+}
+
+Level level() { return kernels()->level; }
+
+Level select(Level level)
+{
+    auto selected = table(std::min(level, supported()));
+    Active.store(selected, std::memory_order_release);
+    return selected->level;
+}
+
+bool validate(const char *data, size_t size)
+{
+    auto simd = kernels();
+    for (size_t i = 0;;)
+    {
+        i += simd->ascii(data + i, size - i);
+        if (i == size) return true;
+
+        size_t length = 0;
+        auto byte = uint8_t(data[i]);
+        uint32_t code = 0;
+        if (byte >= 0xC2 && byte <= 0xDF)
+            length = 2, code = byte & 0x1F;
+        else if (byte >= 0xE0 && byte <= 0xEF)
+            length = 3, code = byte & 0x0F;
+        else if (byte >= 0xF0 && byte <= 0xF4)
+            length = 4, code = byte & 0x07;
+        else
+            return false;
+
+        if (i + length > size) return false;
+        for (size_t j = 1; j < length; ++j)
+        {
+            if ((uint8_t(data[i + j]) & 0xC0) != 0x80) return false;
+            code = (code << 6) | (uint8_t(data[i + j]) & 0x3F);
+        }
+
+        if (length == 3 && (code < 0x800 || (code >= 0xD800 && code <= 0xDFFF))) return false;
+        if (length == 4 && (code < 0x10000 || code > 0x10FFFF)) return false;
+        i += length;
+    }
+}
+}  // namespace Simd
+
 struct Parser
 {
     const char *ptr;
+    const Simd::Kernels *simd;
+    size_t depth, limit;
+    const std::vector<uint32_t> *counts;
+    size_t container;
+};
+
+uint64_t now()
+{
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+namespace Pool
+{
+#ifdef NEYSON_USE_POOL
+const size_t Step = 16;
+const size_t Classes = 8;
+const size_t ChunkSize = 16 * 1024;
+
+struct Bin;
+struct Heap;
+
+union Block
+{
+    Bin *bin;
+    Block *next;
+};
+
+struct Bin
+{
+    Heap *heap;
+    size_t size;
+    Block *free;
+    std::atomic<Block *> remote;
+    std::atomic<size_t> allocations, deallocations, remotes;
+};
+
+struct Heap
+{
+    Bin bins[Classes];
+    std::atomic<size_t> chunks, reserved;
+    Heap *next;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    Heap *heaps = nullptr;
+    std::vector<Heap *> abandoned;
+    size_t count = 0;
+};
+
+std::atomic<bool> Enabled(true);
+
+Registry &registry()
+{
+    // Never destroyed so that values that outlive static destruction can still be freed.
+    static Registry *registry = new Registry;
+    return *registry;
+}
+
+Heap *acquire()
+{
+    auto &registry = Pool::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (!registry.abandoned.empty())
+    {
+        auto heap = registry.abandoned.back();
+        registry.abandoned.pop_back();
+        return heap;
+    }
+
+    auto heap = new Heap;
+    for (size_t i = 0; i < Classes; ++i)
+    {
+        auto &bin = heap->bins[i];
+        bin.heap = heap, bin.size = sizeof(Block) + (i + 1) * Step, bin.free = nullptr;
+        bin.remote = nullptr, bin.allocations = 0, bin.deallocations = 0, bin.remotes = 0;
+    }
+
+    heap->chunks = 0, heap->reserved = 0;
+    heap->next = registry.heaps;
+    registry.heaps = heap;
+    ++registry.count;
+    return heap;
+}
+
+void abandon(Heap *heap)
+{
+    auto &registry = Pool::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.abandoned.push_back(heap);
+}
+
+thread_local Heap *Current = nullptr;
+thread_local bool Finished = false;
+
+struct Owner
+{
+    ~Owner()
+    {
+        if (Current) abandon(Current);
+        Current = nullptr;
+        Finished = true;
+    }
+};
+
+thread_local Owner owner;
+
+Heap *current()
+{
+    if (Current || Finished) return Current;
+    Current = acquire();
+    (void)&owner;
+    return Current;
+}
+
+void refill(Bin &bin)
+{
+    auto count = ChunkSize / bin.size;
+    auto chunk = static_cast<char *>(::operator new(count * bin.size));
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto block = reinterpret_cast<Block *>(chunk + i * bin.size);
+        block->next = bin.free;
+        bin.free = block;
+    }
+    auto heap = bin.heap;
+    heap->chunks.store(heap->chunks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    heap->reserved.store(heap->reserved.load(std::memory_order_relaxed) + count * bin.size, std::memory_order_relaxed);
+}
+
+void *allocate(size_t size)
+{
+    auto index = (size + Step - 1) / Step - 1;
+    auto heap = Enabled.load(std::memory_order_relaxed) && index < Classes ? current() : nullptr;
+    if (heap == nullptr)
+    {
+        auto block = static_cast<Block *>(::operator new(sizeof(Block) + size));
+        block->bin = nullptr;
+        return block + 1;
+    }
+
+    auto &bin = heap->bins[index];
+    if (bin.free == nullptr) bin.free = bin.remote.exchange(nullptr, std::memory_order_acquire);
+    if (bin.free == nullptr) refill(bin);
+
+    auto block = bin.free;
+    bin.free = block->next;
+    block->bin = &bin;
+    bin.allocations.store(bin.allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return block + 1;
+}
+
+void deallocate(void *ptr)
+{
+    auto block = static_cast<Block *>(ptr) - 1;
+    auto bin = block->bin;
+    if (bin == nullptr) return ::operator delete(block);
+
+    if (bin->heap == Current)
+    {
+        block->next = bin->free;
+        bin->free = block;
+        bin->deallocations.store(bin->deallocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    block->next = bin->remote.load(std::memory_order_relaxed);
+    while (!bin->remote.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+        ;
+    bin->remotes.fetch_add(1, std::memory_order_relaxed);
+}
+#else
+void *allocate(size_t size) { return ::operator new(size); }
+
+void deallocate(void *ptr) { ::operator delete(ptr); }
+#endif
+
+bool enable(bool enabled)
+{
+#ifdef NEYSON_USE_POOL
+    return Enabled.exchange(enabled);
+#else
+    return (void)enabled, false;
+#endif
+}
+
+bool enabled()
+{
+#ifdef NEYSON_USE_POOL
+    return Enabled.load();
+#else
+    return false;
+#endif
+}
+
+Stats stats()
+{
+    Stats stats{0, 0, 0, 0, 0, 0, 0};
+#ifdef NEYSON_USE_POOL
+    auto &registry = Pool::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto heap = registry.heaps; heap != nullptr; heap = heap->next)
+    {
+        for (size_t i = 0; i < Classes; ++i)
+        {
+            const auto &bin = heap->bins[i];
+            auto allocations = bin.allocations.load(std::memory_order_relaxed);
+            auto deallocations = bin.deallocations.load(std::memory_order_relaxed);
+            auto remotes = bin.remotes.load(std::memory_order_relaxed);
+
+            stats.allocations += allocations;
+            stats.deallocations += deallocations + remotes;
+            stats.remote += remotes;
+            stats.used += (allocations - deallocations - remotes) * bin.size;
+        }
+        stats.chunks += heap->chunks.load(std::memory_order_relaxed);
+        stats.reserved += heap->reserved.load(std::memory_order_relaxed);
+    }
+    stats.heaps = registry.count;
+#endif
+    return stats;
+}
+}  // namespace Pool
+
+namespace Memory
+{
+std::atomic<const Hooks *> Current(nullptr);
+
+template <typename T>
+struct Kind;
+
+template <>
+struct Kind<String>
+{
+    static const Type type = Type::String;
+};
+
+template <>
+struct Kind<Array>
+{
+    static const Type type = Type::Array;
+};
+
+template <>
+struct Kind<Object>
+{
+    static const Type type = Type::Object;
+};
+
+// The parser turns rejected payloads into errors, so while it runs they are kept and marked instead of failing. The
+// parser resets the value that holds the marked payload which is then freed without calling the deallocate hook.
+thread_local bool Parsing = false;
+thread_local void *Rejected = nullptr;
+
+struct Parse
+{
+    bool previous;
+
+    Parse() : previous(Parsing) { Parsing = true; }
+
+    ~Parse() { Parsing = previous; }
 };
 
+inline bool rejected() { return Current.load(std::memory_order_relaxed) != nullptr && Rejected != nullptr; }
+
+template <typename T>
+T *reject(T *object)
+{
+    if (Parsing) return static_cast<T *>(Rejected = object);
+    object->~T();
+    Pool::deallocate(object);
+    fail("Memory hook rejected the allocation!");
+}
+
+const Hooks *install(const Hooks *hooks) { return Current.exchange(hooks); }
+
+const Hooks *installed() { return Current.load(); }
+}  // namespace Memory
+
+template <typename T, typename... Args>
+T *create(Args &&... args)
+{
+    auto ptr = Pool::allocate(sizeof(T));
+#ifdef NEYSON_NO_EXCEPTIONS
+    auto object = new (ptr) T(std::forward<Args>(args)...);
+    auto hooks = Memory::Current.load(std::memory_order_acquire);
+    if (hooks == nullptr || hooks->allocate == nullptr) return object;
+    auto accepted = hooks->allocate(ptr, sizeof(T), Memory::Kind<T>::type, hooks->data);
+#else
+    T *object;
+    try
+    {
+        object = new (ptr) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        Pool::deallocate(ptr);
+        throw;
+    }
+
+    auto hooks = Memory::Current.load(std::memory_order_acquire);
+    if (hooks == nullptr || hooks->allocate == nullptr) return object;
+    bool accepted;
+    try
+    {
+        accepted = hooks->allocate(ptr, sizeof(T), Memory::Kind<T>::type, hooks->data);
+    }
+    catch (...)
+    {
+        object->~T();
+        Pool::deallocate(ptr);
+        throw;
+    }
+#endif
+    return accepted ? object : Memory::reject(object);
+}
+
+template <typename T>
+void destroy(T *ptr)
+{
+    auto hooks = Memory::Current.load(std::memory_order_acquire);
+    if (ptr == Memory::Rejected)
+        Memory::Rejected = nullptr;
+    else if (hooks != nullptr && hooks->deallocate != nullptr)
+        hooks->deallocate(ptr, sizeof(T), Memory::Kind<T>::type, hooks->data);
+
+    ptr->~T();
+    Pool::deallocate(ptr);
+}
+
 Value::~Value() { reset(); }
 
-Value::Value() : _type(Type::Null) {}
+void Value::mismatch(Type requested) const
+{
+    fail(std::string("Value has type ") + TypeName[int(_type)] + " but you requested " + TypeName[int(requested)] +
+         "!");
+}
+
+Value::Value() : _type(Type::Null) { _value.i = 0; }
 
 Value::Value(const char *val)
 {
     _type = Type::String;
-    _value.s = new String(val);
+    _value.s = create<String>(val);
 }
 
 Value::Value(const Value &val) : _type(val._type), _value(val._value)
 {
-    if (_type == Type::Object) _value.o = new Object(*val._value.o);
-    if (_type == Type::Array) _value.a = new Array(*val._value.a);
-    if (_type == Type::String) _value.s = new String(*val._value.s);
+    if (_type == Type::Object) _value.o = create<Object>(*val._value.o);
+    if (_type == Type::Array) _value.a = create<Array>(*val._value.a);
+    if (_type == Type::String) _value.s = create<String>(*val._value.s);
 }
 
-Value::Value(Value &&val) : _type(val._type), _value(val._value) { val._type = Type::Null; }
+Value::Value(Value &&val) noexcept : _type(val._type), _value(val._value) { val._type = Type::Null; }
 
 Value &Value::operator=(const char *val)
 {
     reset();
+    _value.s = create<String>(val);
     _type = Type::String;
-    _value.s = new String(val);
     return *this;
 }
 
-Value &Value::operator=(Value &&val)
+Value &Value::operator=(Value &&val) noexcept
 {
-    _type = val._type;
-    _value = val._value;
+    if (this == &val) return *this;
+    auto type = val._type;
+    auto value = val._value;
     val._type = Type::Null;
+
+    reset();
+    _type = type;
+    _value = value;
     return *this;
 }
 
 Value &Value::operator=(const Value &val)
 {
-    reset();
-    _type = val._type;
-    _value = val._value;
-    if (_type == Type::Object) _value.o = new Object(*val._value.o);
-    if (_type == Type::Array) _value.a = new Array(*val._value.a);
-    if (_type == Type::String) _value.s = new String(*val._value.s);
-    return *this;
+    if (this == &val) return *this;
+    return *this = Value(val);
 }
 
 void Value::reset()
 {
-    if (_type == Type::Object) delete _value.o;
-    if (_type == Type::Array) delete _value.a;
-    if (_type == Type::String) delete _value.s;
+    if (_type == Type::Object) destroy(_value.o);
+    if (_type == Type::Array) destroy(_value.a);
+    if (_type == Type::String) destroy(_value.s);
     _type = Type::Null;
 }
 
 Function(Construct) Function(Assign) Function(Return);
 
+void Value::reserve(size_t size)
+{
+    if (_type == Type::Array) return _value.a->reserve(size);
+    Assert(_type == Type::Object, "Value is not an array or object to reserve!");
+    _value.o->reserve(size);
+}
+
 const Value &Value::operator[](const std::string &name) const
 {
     const auto &object = this->object();
@@ -191,74 +810,276 @@ const Value &Value::operator[](const std::string &name) const
     return it->second;
 }
 
+Value *Value::find(const std::string &name)
+{
+    if (_type != Type::Object) return nullptr;
+    auto it = _value.o->find(name);
+    return it == _value.o->end() ? nullptr : &it->second;
+}
+
+const Value *Value::find(const std::string &name) const
+{
+    if (_type != Type::Object) return nullptr;
+    auto it = _value.o->find(name);
+    return it == _value.o->end() ? nullptr : &it->second;
+}
+
+bool Value::convert(bool &val) const
+{
+    if (_type == Type::Null) return val = false, true;
+    if (_type == Type::Bool) return val = boolean(), true;
+    if (_type == Type::Integer) return val = bool(integer()), true;
+    if (_type == Type::Real) return val = std::abs(real()) < std::numeric_limits<Real>::epsilon(), true;
+    if (_type == Type::String) return val = !string().empty(), true;
+    if (_type == Type::Array) return val = !array().empty(), true;
+    if (_type == Type::Object) return val = !object().empty(), true;
+    return false;
+}
+
+bool Value::convert(Integer &val) const
+{
+    if (_type == Type::Null) return val = 0, true;
+    if (_type == Type::Bool) return val = Integer(boolean()), true;
+    if (_type == Type::Integer) return val = integer(), true;
+    if (_type == Type::Real) return val = Integer(real()), true;
+    if (_type != Type::String) return false;
+
+    char *end;
+    errno = 0;
+    auto data = string().c_str();
+    val = std::strtoll(data, &end, 10);
+    return end != data && errno != ERANGE;
+}
+
+bool Value::convert(Real &val) const
+{
+    if (_type == Type::Null) return val = 0.0, true;
+    if (_type == Type::Bool) return val = Real(boolean()), true;
+    if (_type == Type::Integer) return val = Real(integer()), true;
+    if (_type == Type::Real) return val = real(), true;
+    if (_type != Type::String) return false;
+
+    char *end;
+    errno = 0;
+    auto data = string().c_str();
+    val = std::strtod(data, &end);
+    return end != data && errno != ERANGE;
+}
+
+bool Value::convert(String &val) const
+{
+    if (_type == Type::Null) return val = "", true;
+    if (_type == Type::Bool) return val = std::to_string(boolean()), true;
+    if (_type == Type::Integer) return val = std::to_string(integer()), true;
+    if (_type == Type::Real) return val = std::to_string(real()), true;
+    if (_type == Type::String) return val = string(), true;
+    return false;
+}
+
 Neyson::Value::operator bool() const
 {
-    if (_type == Type::Null) return false;
-    if (_type == Type::Bool) return boolean();
-    if (_type == Type::Integer) return bool(integer());
-    if (_type == Type::Real) return std::abs(real()) < std::numeric_limits<Real>::epsilon();
-    if (_type == Type::String) return !string().empty();
-    if (_type == Type::Array) return !array().empty();
-    if (_type == Type::Object) return !object().empty();
-    throw std::runtime_error("Value is not convertable to boolean!");
+    bool val;
+    Assert(convert(val), "Value is not convertable to boolean!");
+    return val;
 }
 
 Neyson::Value::operator Integer() const
 {
-    if (_type == Type::Null) return 0;
-    if (_type == Type::Bool) return Integer(boolean());
-    if (_type == Type::Integer) return integer();
-    if (_type == Type::Real) return Integer(real());
-    if (_type == Type::String) return std::stoll(string());
-    throw std::runtime_error("Value is not convertable to integer!");
+    Integer val;
+    Assert(convert(val), "Value is not convertable to integer!");
+    return val;
 }
 
 Neyson::Value::operator Real() const
 {
-    if (_type == Type::Null) return 0.0;
-    if (_type == Type::Bool) return Real(boolean());
-    if (_type == Type::Integer) return Real(integer());
-    if (_type == Type::Real) return real();
-    if (_type == Type::String) return std::stod(string());
-    throw std::runtime_error("Value is not convertable to real!");
+    Real val;
+    Assert(convert(val), "Value is not convertable to real!");
+    return val;
 }
 
 Neyson::Value::operator String() const
 {
-    if (_type == Type::Null) return "";
-    if (_type == Type::Bool) return std::to_string(boolean());
-    if (_type == Type::Integer) return std::to_string(integer());
-    if (_type == Type::Real) return std::to_string(real());
-    if (_type == Type::String) return string();
-    throw std::runtime_error("Value is not convertable to string!");
+    String val;
+    Assert(convert(val), "Value is not convertable to string!");
+    return val;
 }
 
-Error readValue(Value &value, Parser &parser);
+namespace Trace
+{
+#ifdef NEYSON_USE_TRACE
+struct Event
+{
+    std::atomic<uint64_t> sequence, start, duration;
+    std::atomic<uint32_t> thread, phase;
+};
 
-bool fixString(String &string, const char *ptr, size_t len)
+struct Buffer
 {
-    size_t j = 0;
-    string.resize(len);
-    bool escape = false;
+    std::vector<Event> events;
+    std::atomic<uint64_t> head;
 
-    for (size_t i = 0; i < len; ++i)
-        if (!escape)
-        {
-            if (ptr[i] == '\\')
-                escape = true;
-            else
-                string[j++] = ptr[i];
-        }
-        else
-        {
-            escape = false;
-            if (ptr[i] == '\"')
-                string[j++] = '\"';
-            else if (ptr[i] == '\\')
-                string[j++] = '\\';
-            else if (ptr[i] == '/')
-                string[j++] = '/';
-            else if (ptr[i] == 'b')
+    Buffer(size_t capacity) : events(capacity), head(0) {}
+};
+
+std::atomic<bool> Enabled(false);
+std::atomic<Buffer *> Current(nullptr);
+std::atomic<uint32_t> Threads(0);
+thread_local uint32_t Thread = 0;
+thread_local bool Paused = false;
+
+void record(Phase phase, uint64_t start, uint64_t end)
+{
+    auto buffer = Current.load(std::memory_order_acquire);
+    if (buffer == nullptr || Paused) return;
+    if (Thread == 0) Thread = ++Threads;
+
+    auto index = buffer->head.fetch_add(1, std::memory_order_relaxed);
+    auto &event = buffer->events[index % buffer->events.size()];
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.start.store(start, std::memory_order_relaxed);
+    event.duration.store(end - start, std::memory_order_relaxed);
+    event.thread.store(Thread, std::memory_order_relaxed);
+    event.phase.store(uint32_t(phase), std::memory_order_relaxed);
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+struct Scope
+{
+    Phase phase;
+    uint64_t start;
+
+    Scope(Phase phase) : phase(phase), start(Enabled.load(std::memory_order_relaxed) ? now() : 0) {}
+    ~Scope()
+    {
+        if (start != 0) record(phase, start, now());
+    }
+};
+
+#define Traced(P) Trace::Scope scope(Trace::Phase::P)
+#else
+#define Traced(P)
+#endif
+
+void start(size_t capacity)
+{
+#ifdef NEYSON_USE_TRACE
+    auto buffer = Current.load();
+    // Old buffers are never freed since other threads might still be recording into them.
+    if (buffer == nullptr || buffer->events.size() != std::max<size_t>(capacity, 1))
+        Current.store(buffer = new Buffer(std::max<size_t>(capacity, 1)));
+    else
+        for (auto &event : buffer->events) event.sequence.store(0);
+    Enabled.store(true);
+#else
+    (void)capacity;
+#endif
+}
+
+void stop()
+{
+#ifdef NEYSON_USE_TRACE
+    Enabled.store(false);
+#endif
+}
+
+bool enabled()
+{
+#ifdef NEYSON_USE_TRACE
+    return Enabled.load();
+#else
+    return false;
+#endif
+}
+
+Value dump()
+{
+    Array events;
+#ifdef NEYSON_USE_TRACE
+    auto buffer = Current.load(std::memory_order_acquire);
+    std::vector<std::pair<uint64_t, Value>> sorted;
+    for (size_t i = 0; buffer != nullptr && i < buffer->events.size(); ++i)
+    {
+        const auto &event = buffer->events[i];
+        auto sequence = event.sequence.load(std::memory_order_acquire);
+        auto start = event.start.load(std::memory_order_relaxed);
+        auto duration = event.duration.load(std::memory_order_relaxed);
+        auto thread = event.thread.load(std::memory_order_relaxed);
+        auto phase = event.phase.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence == 0 || sequence != event.sequence.load(std::memory_order_relaxed)) continue;
+
+        std::ostringstream name;
+        name << Phase(phase);
+        sorted.emplace_back(start, Object{
+                                       {"name", name.str()},
+                                       {"cat", "neyson"},
+                                       {"ph", "X"},
+                                       {"ts", Real(start) / 1000},
+                                       {"dur", Real(duration) / 1000},
+                                       {"pid", 1},
+                                       {"tid", thread},
+                                   });
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<uint64_t, Value> &a, const std::pair<uint64_t, Value> &b) {
+        return a.first < b.first;
+    });
+    for (auto &pair : sorted) events.push_back(std::move(pair.second));
+#endif
+    return Object{{"traceEvents", std::move(events)}, {"displayTimeUnit", "ns"}};
+}
+
+Result fdump(const std::string &path)
+{
+#ifdef NEYSON_USE_TRACE
+    Paused = true;
+    auto result = IO::fwrite(dump(), path);
+    Paused = false;
+    return result;
+#else
+    return IO::fwrite(dump(), path);
+#endif
+}
+}  // namespace Trace
+
+template <IO::Numbers N, bool Duplicates, bool Validate, bool Limited>
+struct Rules
+{
+    static const IO::Numbers numbers = N;
+    static const bool duplicates = Duplicates;
+    static const bool validate = Validate;
+    static const bool limited = Limited;
+};
+
+template <typename R>
+Error readValue(Value &value, Parser &parser);
+
+bool fixString(String &string, const char *ptr, size_t len)
+{
+    Traced(Decode);
+    size_t j = 0;
+    string.resize(len);
+    bool escape = false;
+
+    for (size_t i = 0; i < len; ++i)
+        if (!escape)
+        {
+            if (ptr[i] == '\\')
+                escape = true;
+            else
+                string[j++] = ptr[i];
+        }
+        else
+        {
+            escape = false;
+            if (ptr[i] == '\"')
+                string[j++] = '\"';
+            else if (ptr[i] == '\\')
+                string[j++] = '\\';
+            else if (ptr[i] == '/')
+                string[j++] = '/';
+            else if (ptr[i] == 'b')
                 string[j++] = '\b';
             else if (ptr[i] == 'f')
                 string[j++] = '\f';
@@ -318,25 +1139,104 @@ bool fixString(String &string, const char *ptr, size_t len)
     return 0;
 }
 
+template <typename R>
 Error readString(String &string, Parser &parser)
 {
     Read('\"', Error::ExpectedQuoteOpen);
     auto ptr = parser.ptr;
-    for (bool state = true; parser.ptr[0] != '\0'; ++parser.ptr)
     {
-        if (parser.ptr[0] == '\"' && state) break;
-        state = (parser.ptr[0] == '\\') ? !state : true;
+        Traced(Scan);
+        parser.ptr = parser.simd->string(parser.ptr);
+        while (parser.ptr[0] == '\\' && parser.ptr[1] != '\0') parser.ptr = parser.simd->string(parser.ptr + 2);
+        if (parser.ptr[0] == '\\') ++parser.ptr;
     }
 
     if (parser.ptr[0] == '\0') return Error::ExpectedQuoteClose;
+    if (R::validate && !Simd::validate(ptr, parser.ptr - ptr)) return Error::InvalidEncoding;
     fixString(string, ptr, parser.ptr - ptr);
     ++parser.ptr;
     return Error::None;
 }
 
+// Counts the items of each array and object in the order of their opening brackets in one pass over the first value
+// of the document so that the parser can reserve them. The counts are only hints and might be wrong for invalid documents.
+void count(const char *ptr, const Simd::Kernels *simd, std::vector<uint32_t> &counts)
+{
+    enum Class : uint8_t
+    {
+        Other,
+        Space,
+        Quote,
+        Comma,
+        Open,
+        Close,
+        End,
+    };
+    static const struct Table
+    {
+        Class classes[256];
+        Table() : classes()
+        {
+            for (auto chr : " \n\r\t:") classes[uint8_t(chr)] = Space;
+            classes[uint8_t('"')] = Quote, classes[uint8_t(',')] = Comma;
+            classes[uint8_t('[')] = classes[uint8_t('{')] = Open;
+            classes[uint8_t(']')] = classes[uint8_t('}')] = Close;
+            classes[0] = End;
+        }
+    } table;
+
+    std::vector<uint32_t> stack;
+    bool empty = false;
+    for (;; ++ptr)
+    {
+        auto type = table.classes[uint8_t(ptr[0])];
+        if (type == Space) continue;
+        if (type == End) return;
+        if (type == Comma)
+        {
+            if (!stack.empty()) ++counts[stack.back()];
+            continue;
+        }
+        if (type == Close)
+        {
+            if (stack.empty()) return;
+            stack.pop_back();
+            if (stack.empty()) return;
+            empty = false;
+            continue;
+        }
+
+        if (stack.empty() && type != Open) return;
+        if (empty) counts[stack.back()] = 1, empty = false;
+        if (type == Open)
+        {
+            stack.push_back(uint32_t(counts.size()));
+            counts.push_back(0);
+            empty = true;
+        }
+        else if (type == Quote)
+        {
+            ptr = simd->string(ptr + 1);
+            while (ptr[0] == '\\' && ptr[1] != '\0') ptr = simd->string(ptr + 2);
+            if (ptr[0] != '"') return;
+        }
+    }
+}
+
+template <typename C>
+void reserve(C &container, Parser &parser)
+{
+    if (parser.counts == nullptr || parser.container >= parser.counts->size()) return;
+    container.reserve((*parser.counts)[parser.container++]);
+}
+
+template <typename R>
 Error readObject(Object &object, Parser &parser)
 {
+    Traced(Build);
+    if (R::limited && ++parser.depth > parser.limit) return Error::DepthExceeded;
     Read('{', Error::ExpectedBraceOpen);
+    reserve(object, parser);
     auto it = object.begin();
     while (true)
     {
@@ -344,328 +1244,1654 @@ Error readObject(Object &object, Parser &parser)
         if (parser.ptr[0] == '}')
         {
             ++parser.ptr;
+            parser.depth -= R::limited;
             return Error::None;
         }
 
         String string;
-        auto error = readString(string, parser);
+        auto key = parser.ptr;
+        auto error = readString<R>(string, parser);
         if (error != Error::None) return error;
         Skip(Error::ExpectedColon) Read(':', Error::ExpectedColon);
 
         Value value;
-        error = readValue(value, parser);
+        error = readValue<R>(value, parser);
         if (error != Error::None) return error;
+        auto size = object.size();
         it = object.emplace_hint(it, std::move(string), std::move(value));
+        if (!R::duplicates && object.size() == size)
+        {
+            parser.ptr = key;
+            return Error::DuplicateKey;
+        }
         Skip(Error::ExpectedCommaOrBraceClose) if (parser.ptr[0] != '}') Read(',', Error::ExpectedComma);
     }
 }
 
-Error readArray(Array &array, Parser &parser)
+template <typename R>
+Error readArray(Array &array, Parser &parser)
+{
+    Traced(Build);
+    if (R::limited && ++parser.depth > parser.limit) return Error::DepthExceeded;
+    Read('[', Error::ExpectedBracketOpen);
+    reserve(array, parser);
+    while (true)
+    {
+        Skip(Error::ExpectedBracketClose);
+        if (parser.ptr[0] == ']')
+        {
+            ++parser.ptr;
+            parser.depth -= R::limited;
+            return Error::None;
+        }
+
+        Value value;
+        auto error = readValue<R>(value, parser);
+        if (error != Error::None) return error;
+        array.push_back(std::move(value));
+        Skip(Error::ExpectedCommaOrBracketClose) if (parser.ptr[0] != ']') Read(',', Error::ExpectedComma);
+    }
+}
+
+// Checks the number against the grammar of RFC 8259 (or only its integer part).
+bool strict(const char *ptr, const char *end, bool integer)
+{
+    auto digits = [&]() {
+        auto start = ptr;
+        while (ptr < end && ptr[0] >= '0' && ptr[0] <= '9') ++ptr;
+        return ptr != start;
+    };
+
+    if (ptr < end && ptr[0] == '-') ++ptr;
+    if (ptr < end && ptr[0] == '0')
+        ++ptr;
+    else if (!digits())
+        return false;
+    if (integer) return ptr == end;
+
+    if (ptr < end && ptr[0] == '.' && (++ptr, !digits())) return false;
+    if (ptr < end && (ptr[0] == 'e' || ptr[0] == 'E'))
+    {
+        ++ptr;
+        if (ptr < end && (ptr[0] == '+' || ptr[0] == '-')) ++ptr;
+        if (!digits()) return false;
+    }
+    return ptr == end;
+}
+
+template <typename R>
+Error readNumber(Value &number, Parser &parser)
+{
+    Traced(Number);
+    auto end = parser.simd->number(parser.ptr);
+    if (R::numbers != IO::Numbers::Lenient && !strict(parser.ptr, end, R::numbers == IO::Numbers::Integer))
+        return Error::InvalidNumber;
+
+    auto ptr = parser.ptr + (parser.ptr[0] == '-');
+    if (end > ptr && end - ptr <= 18 && std::all_of(ptr, end, [](char c) { return c >= '0' && c <= '9'; }))
+    {
+        Integer integer = 0;
+        for (; ptr < end; ++ptr) integer = integer * 10 + (ptr[0] - '0');
+        number = parser.ptr[0] == '-' ? -integer : integer;
+        parser.ptr = end;
+        return Error::None;
+    }
+
+    char *last;
+    errno = 0;
+    std::string string(parser.ptr, end);
+    if (string.find_first_of(".eE") == std::string::npos)
+        number = Integer(std::strtoll(string.c_str(), &last, 10));
+    else
+        number = Real(std::strtod(string.c_str(), &last));
+    if (last == string.c_str() || errno == ERANGE) return Error::InvalidNumber;
+
+    parser.ptr = end;
+    return Error::None;
+}
+
+// Returns false after resetting the value if the memory hook rejected the payload that was just created for it.
+inline bool created(Value &value)
+{
+    if (!Memory::rejected()) return true;
+    value.reset();
+    return false;
+}
+
+template <typename R>
+Error readValue(Value &value, Parser &parser)
+{
+    Skip(Error::ExpectedStart);
+    if (parser.ptr[0] == '{')
+    {
+        auto &object = value.object({});
+        return created(value) ? readObject<R>(object, parser) : Error::AllocationRejected;
+    }
+    if (parser.ptr[0] == '[')
+    {
+        auto &array = value.array({});
+        return created(value) ? readArray<R>(array, parser) : Error::AllocationRejected;
+    }
+    if (parser.ptr[0] == '\"')
+    {
+        auto &string = value.string({});
+        return created(value) ? readString<R>(string, parser) : Error::AllocationRejected;
+    }
+    if (strchr(R::numbers == IO::Numbers::Lenient ? "-+.0123456789" : "-0123456789", parser.ptr[0]) != NULL)
+        return readNumber<R>(value, parser);
+
+    if (strncmp(parser.ptr, "true", 4) == 0)
+    {
+        parser.ptr += 4;
+        value = true;
+        return Error::None;
+    }
+    if (strncmp(parser.ptr, "false", 5) == 0)
+    {
+        parser.ptr += 5;
+        value = false;
+        return Error::None;
+    }
+    if (strncmp(parser.ptr, "null", 4) == 0)
+    {
+        parser.ptr += 4;
+        value = Value();
+        return Error::None;
+    }
+    return Error::UnexpectedValueStart;
+}
+
+typedef Error (*Reader)(Value &value, Parser &parser);
+
+template <IO::Numbers N, bool D, bool V>
+Reader limited(const IO::Policy &policy)
+{
+    return policy.depth != 0 ? readValue<Rules<N, D, V, true>> : readValue<Rules<N, D, V, false>>;
+}
+
+template <IO::Numbers N, bool D>
+Reader validated(const IO::Policy &policy)
+{
+    return policy.validate ? limited<N, D, true>(policy) : limited<N, D, false>(policy);
+}
+
+template <IO::Numbers N>
+Reader unique(const IO::Policy &policy)
+{
+    return policy.duplicates ? validated<N, true>(policy) : validated<N, false>(policy);
+}
+
+// Each policy has its own instantiation of the parser which is chosen once per document.
+Reader reader(const IO::Policy &policy)
+{
+    if (policy.numbers == IO::Numbers::Strict) return unique<IO::Numbers::Strict>(policy);
+    if (policy.numbers == IO::Numbers::Integer) return unique<IO::Numbers::Integer>(policy);
+    return unique<IO::Numbers::Lenient>(policy);
+}
+
+// Parses the value at the start of the string (after whitespace) and returns the number of bytes up to its end.
+Result parse(Value &value, const char *str, const IO::Policy &policy, std::vector<uint32_t> &counts)
+{
+    value.reset();
+    Parser parser{str, Simd::kernels(), 0, policy.depth, nullptr, 0};
+    if (policy.reserve)
+    {
+        counts.clear();
+        count(str, parser.simd, counts);
+        parser.counts = &counts;
+    }
+    Memory::Parse parse;
+    auto error = reader(policy)(value, parser);
+    return Result{error, size_t(parser.ptr - str)};
+}
+
+Error unfixString(String &string)
+{
+    auto simd = Simd::kernels();
+    auto data = string.c_str();
+    auto ptr = simd->escape(data);
+    if (ptr == data + string.size()) return Error::None;
+
+    String output;
+    output.reserve(string.size() + 16);
+    output.append(data, ptr);
+    for (size_t i = ptr - data; i < string.size(); ++i)
+    {
+        auto next = size_t(simd->escape(data + i) - data);
+        output.append(data + i, next - i);
+        if ((i = next) == string.size()) break;
+
+        if ((string[i] & 0xF8) == 0xF0)
+        {
+            if (i + 4 > string.size()) return Error::InvalidString;
+            output.append(string.data() + i, 4);
+            i += 3;
+        }
+        else if ((string[i] & 0xF0) == 0xE0)
+        {
+            if (i + 3 > string.size()) return Error::InvalidString;
+            output.append(string.data() + i, 3);
+            i += 2;
+        }
+        else if ((string[i] & 0xE0) == 0xC0)
+        {
+            if (i + 2 > string.size()) return Error::InvalidString;
+            output.append(string.data() + i, 2);
+            i += 1;
+        }
+
+        else if (string[i] == '\"')
+            output.append("\\\"");
+        else if (string[i] == '\\')
+            output.append("\\\\");
+        else if (string[i] == '/')
+            output.append("\\/");
+        else if (string[i] == '\b')
+            output.append("\\b");
+        else if (string[i] == '\f')
+            output.append("\\f");
+        else if (string[i] == '\n')
+            output.append("\\n");
+        else if (string[i] == '\r')
+            output.append("\\r");
+        else if (string[i] == '\t')
+            output.append("\\t");
+
+        else if (string[i] < 10)
+            output.append("\\u000").push_back('0' + string[i]);
+        else if (string[i] < 16)
+            output.append("\\u000").push_back('A' + string[i] - 10);
+        else if (string[i] < 26)
+            output.append("\\u001").push_back('0' + string[i] - 16);
+        else if (string[i] < 32)
+            output.append("\\u001").push_back('A' + string[i] - 26);
+
+        else
+            output.push_back(string[i]);
+    }
+
+    string = std::move(output);
+    return Error::None;
+}
+
+Error writeString(String string, std::ostream *stream)
+{
+    auto error = unfixString(string);
+    if (error != Error::None) return error;
+    *stream << '\"' << string << '\"';
+    return Error::None;
+}
+
+Error writeReal(double number, std::ostream *stream)
+{
+    if (std::isnan(number) || std::isinf(number)) return Error::InvalidNumber;
+    *stream << std::setprecision(16) << number;
+    return Error::None;
+}
+
+Error writeValue(const Value &value, std::ostream *stream);
+
+Error writeObject(const Object &object, std::ostream *stream)
+{
+    size_t i = 0;
+    *stream << '{';
+    for (const auto &pair : object)
+    {
+        if (i++ != 0) *stream << ',';
+        auto error = writeString(pair.first, stream);
+        if (error != Error::None) return error;
+
+        *stream << ':';
+        error = writeValue(pair.second, stream);
+        if (error != Error::None) return error;
+    }
+
+    *stream << '}';
+    return Error::None;
+}
+
+Error writeArray(const Array &array, std::ostream *stream)
+{
+    *stream << '[';
+    for (size_t i = 0; i < array.size(); ++i)
+    {
+        if (i != 0) *stream << ',';
+        auto error = writeValue(array[i], stream);
+        if (error != Error::None) return error;
+    }
+
+    *stream << ']';
+    return Error::None;
+}
+
+Error writeValue(const Value &value, std::ostream *stream)
+{
+    if (value.type() == Type::Object) return writeObject(value.object(), stream);
+    if (value.type() == Type::Array) return writeArray(value.array(), stream);
+    if (value.type() == Type::String) return writeString(value.string(), stream);
+    if (value.type() == Type::Real) return writeReal(value.real(), stream);
+
+    if (value.type() == Type::Integer)
+        *stream << value.integer();
+    else if (value.type() == Type::Bool)
+        *stream << (value.boolean() ? "true" : "false");
+    else if (value.type() == Type::Null)
+        *stream << "null";
+    else
+        return Error::InvalidValueType;
+    return Error::None;
+}
+
+Error writeValue(const Value &value, std::ostream *stream, size_t indent);
+
+Error writeObject(const Object &object, std::ostream *stream, size_t indent)
+{
+    if (object.empty())
+    {
+        *stream << "{}";
+        return Error::None;
+    }
+
+    size_t i = 0;
+    *stream << "{\n";
+    for (const auto &pair : object)
+    {
+        if (i++ != 0) *stream << ",\n";
+        *stream << std::string((indent + 1) * 4, ' ');
+        auto error = writeString(pair.first, stream);
+        if (error != Error::None) return error;
+
+        *stream << ": ";
+        error = writeValue(pair.second, stream, indent + 1);
+        if (error != Error::None) return error;
+    }
+
+    *stream << '\n' << std::string(indent * 4, ' ') << '}';
+    return Error::None;
+}
+
+Error writeArray(const Array &array, std::ostream *stream, size_t indent)
+{
+    if (array.empty())
+    {
+        *stream << "[]";
+        return Error::None;
+    }
+
+    *stream << "[\n";
+    for (size_t i = 0; i < array.size(); ++i)
+    {
+        if (i != 0) *stream << ",\n";
+        *stream << std::string((indent + 1) * 4, ' ');
+        auto error = writeValue(array[i], stream, indent + 1);
+        if (error != Error::None) return error;
+    }
+
+    *stream << '\n' << std::string(indent * 4, ' ') << ']';
+    return Error::None;
+}
+
+Error writeValue(const Value &value, std::ostream *stream, size_t indent)
+{
+    if (value.type() == Type::Object) return writeObject(value.object(), stream, indent);
+    if (value.type() == Type::Array) return writeArray(value.array(), stream, indent);
+    if (value.type() == Type::String) return writeString(value.string(), stream);
+    if (value.type() == Type::Real) return writeReal(value.real(), stream);
+
+    if (value.type() == Type::Integer)
+        *stream << value.integer();
+    else if (value.type() == Type::Bool)
+        *stream << (value.boolean() ? "true" : "false");
+    else if (value.type() == Type::Null)
+        *stream << "null";
+    else
+        return Error::InvalidValueType;
+    return Error::None;
+}
+
+void measure(const Value &value, Stats &stats, size_t depth)
+{
+    ++stats.values[int(value.type())];
+    stats.depth = std::max(stats.depth, depth);
+    if (value.type() == Type::String)
+    {
+        ++stats.allocations;
+        stats.string = std::max(stats.string, value.string().size());
+    }
+    else if (value.type() == Type::Array)
+    {
+        ++stats.allocations;
+        stats.array = std::max(stats.array, value.array().size());
+        for (const auto &item : value.array()) measure(item, stats, depth + 1);
+    }
+    else if (value.type() == Type::Object)
+    {
+        ++stats.allocations;
+        stats.object = std::max(stats.object, value.object().size());
+        for (const auto &pair : value.object()) measure(pair.second, stats, depth + 1);
+    }
+}
+
+namespace Metrics
+{
+const size_t Operations = 4, Sizes = 5;
+
+struct Counters
+{
+    std::atomic<uint64_t> calls, errors, bytes, count, sum;
+    std::atomic<uint64_t> counts[Histogram::Buckets];
+};
+
+struct Shard
+{
+    Counters counters[Operations][Sizes];
+    std::atomic<bool> owned;
+    Shard *next;
+};
+
+std::atomic<bool> Enabled(false);
+std::atomic<Shard *> Shards(nullptr);
+thread_local Shard *Current = nullptr;
+thread_local size_t Depth = 0;
+
+std::mutex &mutex()
+{
+    static std::mutex *mutex = new std::mutex;
+    return *mutex;
+}
+
+Snapshot &baseline()
+{
+    static Snapshot *baseline = new Snapshot();
+    return *baseline;
+}
+
+void add(std::atomic<uint64_t> &counter, uint64_t value)
+{
+    // Only the owner thread writes to a shard so a plain load and store is enough.
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct Owner
+{
+    ~Owner()
+    {
+        if (Current) Current->owned.store(false, std::memory_order_release);
+        Current = nullptr;
+    }
+};
+
+thread_local Owner owner;
+
+Shard *current()
+{
+    if (Current) return Current;
+    for (auto shard = Shards.load(std::memory_order_acquire); shard != nullptr; shard = shard->next)
+    {
+        bool owned = false;
+        if (shard->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) return Current = shard;
+    }
+
+    auto shard = new Shard();
+    shard->owned = true;
+    shard->next = Shards.load(std::memory_order_relaxed);
+    while (!Shards.compare_exchange_weak(shard->next, shard, std::memory_order_release, std::memory_order_relaxed))
+        ;
+
+    (void)&owner;
+    return Current = shard;
+}
+
+void record(Operation operation, size_t bytes, uint64_t time, bool error)
+{
+    auto &counters = current()->counters[int(operation)][int(size(bytes))];
+    add(counters.calls, 1);
+    add(counters.errors, error ? 1 : 0);
+    add(counters.bytes, bytes);
+    add(counters.count, 1);
+    add(counters.sum, time);
+    add(counters.counts[Histogram::bucket(time)], 1);
+}
+
+struct Call
+{
+    Operation operation;
+    uint64_t start;
+
+    Call(Operation operation) : operation(operation), start(0)
+    {
+        if (Depth++ == 0 && Enabled.load(std::memory_order_relaxed)) start = now();
+    }
+
+    Result operator()(const Result &result, size_t bytes)
+    {
+        if (start != 0) record(operation, bytes, now() - start, !result);
+        start = 0;
+        return result;
+    }
+
+    ~Call() { --Depth; }
+};
+
+Histogram::Histogram() : counts{}, count(0), sum(0) {}
+
+size_t Histogram::bucket(uint64_t value)
+{
+    if (value < 8) return size_t(value);
+    size_t exponent = 63;
+    while ((value >> exponent) == 0) --exponent;
+    if (exponent > 40) return Buckets - 1;
+    return (exponent - 2) * 8 + size_t((value >> (exponent - 3)) & 7);
+}
+
+uint64_t Histogram::upper(size_t bucket)
+{
+    if (bucket < 8) return bucket;
+    auto exponent = bucket / 8 + 2;
+    return ((uint64_t(8 + bucket % 8 + 1)) << (exponent - 3)) - 1;
+}
+
+void Histogram::record(uint64_t value)
+{
+    ++counts[bucket(value)];
+    ++count;
+    sum += value;
+}
+
+void Histogram::merge(const Histogram &other)
+{
+    for (size_t i = 0; i < Buckets; ++i) counts[i] += other.counts[i];
+    count += other.count;
+    sum += other.sum;
+}
+
+uint64_t Histogram::quantile(double q) const
+{
+    if (count == 0) return 0;
+    auto rank = uint64_t(std::ceil(std::min(std::max(q, 0.0), 1.0) * double(count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < Buckets; ++i)
+        if ((seen += counts[i]) >= std::max<uint64_t>(rank, 1)) return upper(i);
+    return upper(Buckets - 1);
+}
+
+double Histogram::mean() const { return count == 0 ? 0 : double(sum) / double(count); }
+
+uint64_t Histogram::max() const { return quantile(1); }
+
+bool enable(bool enabled) { return Enabled.exchange(enabled); }
+
+bool enabled() { return Enabled.load(); }
+
+Size size(size_t bytes)
+{
+    if (bytes < (size_t(1) << 10)) return Size::Tiny;
+    if (bytes < (size_t(1) << 14)) return Size::Small;
+    if (bytes < (size_t(1) << 18)) return Size::Medium;
+    if (bytes < (size_t(1) << 22)) return Size::Large;
+    return Size::Huge;
+}
+
+Snapshot collect()
+{
+    auto snapshot = Snapshot();
+    for (auto shard = Shards.load(std::memory_order_acquire); shard != nullptr; shard = shard->next)
+        for (size_t i = 0; i < Operations; ++i)
+            for (size_t j = 0; j < Sizes; ++j)
+            {
+                const auto &counters = shard->counters[i][j];
+                auto &entry = snapshot.entries[i][j];
+                entry.calls += counters.calls.load(std::memory_order_relaxed);
+                entry.errors += counters.errors.load(std::memory_order_relaxed);
+                entry.bytes += counters.bytes.load(std::memory_order_relaxed);
+                entry.latency.count += counters.count.load(std::memory_order_relaxed);
+                entry.latency.sum += counters.sum.load(std::memory_order_relaxed);
+                for (size_t k = 0; k < Histogram::Buckets; ++k)
+                    entry.latency.counts[k] += counters.counts[k].load(std::memory_order_relaxed);
+            }
+    return snapshot;
+}
+
+Snapshot snapshot()
+{
+    auto snapshot = collect();
+    std::lock_guard<std::mutex> lock(mutex());
+    const auto &baseline = Metrics::baseline();
+    for (size_t i = 0; i < Operations; ++i)
+        for (size_t j = 0; j < Sizes; ++j)
+        {
+            auto &entry = snapshot.entries[i][j];
+            const auto &base = baseline.entries[i][j];
+            entry.calls -= std::min(entry.calls, base.calls);
+            entry.errors -= std::min(entry.errors, base.errors);
+            entry.bytes -= std::min(entry.bytes, base.bytes);
+            entry.latency.count -= std::min(entry.latency.count, base.latency.count);
+            entry.latency.sum -= std::min(entry.latency.sum, base.latency.sum);
+            for (size_t k = 0; k < Histogram::Buckets; ++k)
+                entry.latency.counts[k] -= std::min(entry.latency.counts[k], base.latency.counts[k]);
+        }
+    return snapshot;
+}
+
+void reset()
+{
+    auto snapshot = collect();
+    std::lock_guard<std::mutex> lock(mutex());
+    baseline() = snapshot;
+}
+
+Value report(const Snapshot &snapshot)
+{
+    Object report;
+    for (size_t i = 0; i < Operations; ++i)
+    {
+        Object sizes;
+        for (size_t j = 0; j < Sizes; ++j)
+        {
+            const auto &entry = snapshot.entries[i][j];
+            if (entry.calls == 0) continue;
+
+            std::ostringstream name;
+            name << Size(j);
+            const auto &latency = entry.latency;
+            sizes[name.str()] = Object{
+                {"calls", entry.calls},
+                {"errors", entry.errors},
+                {"bytes", entry.bytes},
+                {"mean", latency.mean()},
+                {"p50", latency.quantile(.5)},
+                {"p90", latency.quantile(.9)},
+                {"p99", latency.quantile(.99)},
+                {"p999", latency.quantile(.999)},
+                {"max", latency.max()},
+            };
+        }
+
+        std::ostringstream name;
+        name << Operation(i);
+        report[name.str()] = std::move(sizes);
+    }
+    return report;
+}
+}  // namespace Metrics
+
+// Reads up to size bytes at the offset of the file and returns the number of bytes read. Uses pread where it is
+// available so that threads can read the same file without sharing its position.
+size_t readAt(FILE *file, uint64_t offset, char *data, size_t size)
+{
+    Traced(FileIO);
+#if defined(_WIN32)
+    if (_fseeki64(file, int64_t(offset), SEEK_SET) != 0) return 0;
+    return fread(data, 1, size, file);
+#else
+    size_t total = 0;
+    while (total < size)
+    {
+        auto count = pread(fileno(file), data + total, size - total, off_t(offset + total));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        total += size_t(count);
+    }
+    return total;
+#endif
+}
+
+uint64_t sizeOf(FILE *file)
+{
+#if defined(_WIN32)
+    _fseeki64(file, 0, SEEK_END);
+    return uint64_t(_ftelli64(file));
+#else
+    struct stat status;
+    return fstat(fileno(file), &status) == 0 ? uint64_t(status.st_size) : 0;
+#endif
+}
+
+namespace IO
+{
+Result read(Value &value, const char *str, const Policy &policy, Stats *stats)
+{
+    Metrics::Call call(Metrics::Operation::Read);
+    Traced(Read);
+    auto start = stats ? now() : 0;
+    std::vector<uint32_t> counts;
+    auto result = parse(value, str, policy, counts);
+    result.index = size_t(Simd::kernels()->whitespace(str + result.index) - str);
+
+    if (stats)
+    {
+        *stats = Stats{};
+        stats->process = now() - start;
+        stats->bytes = result.index;
+        measure(value, *stats, 0);
+    }
+    return call(result, result.index);
+}
+
+Result read(Value &value, const std::string &str, const Policy &policy, Stats *stats)
+{
+    Metrics::Call call(Metrics::Operation::Read);
+    auto result = read(value, str.c_str(), policy, stats);
+    if (result.error == Error::None && result.index != str.size()) result.error = Error::FailedToReachEnd;
+    return call(result, str.size());
+}
+
+Result fread(Value &value, const std::string &path, const Policy &policy, Stats *stats)
+{
+    Metrics::Call call(Metrics::Operation::FRead);
+    if (stats) *stats = Stats{};
+    auto start = stats ? now() : 0;
+    std::string data;
+    {
+        Traced(FileIO);
+        auto file = fopen(path.c_str(), "r");
+        if (file == NULL) return call(Result{Error::FileIOError, 0}, 0);
+
+        fseek(file, 0, SEEK_END);
+        data.resize(ftell(file));
+        rewind(file);
+        fread(&data[0], 1, data.size(), file);
+        fclose(file);
+    }
+    auto io = stats ? now() - start : 0;
+    auto result = read(value, data, policy, stats);
+    if (stats) stats->io = io;
+    return call(result, data.size());
+}
+
+Result read(Value &value, const char *str, Stats *stats) { return read(value, str, Policy(), stats); }
+
+Result read(Value &value, const std::string &str, Stats *stats) { return read(value, str, Policy(), stats); }
+
+Result fread(Value &value, const std::string &path, Stats *stats) { return fread(value, path, Policy(), stats); }
+
+Result write(const Value &value, std::ostream *stream, Mode mode, Stats *stats)
+{
+    Metrics::Call call(Metrics::Operation::Write);
+    Traced(Write);
+    auto start = stats ? now() : 0;
+    auto position = stats || call.start ? stream->tellp() : std::streampos(-1);
+    auto error = mode == Mode::Readable ? writeValue(value, stream, 0) : writeValue(value, stream);
+
+    if (stats)
+    {
+        *stats = Stats{};
+        stats->process = now() - start;
+        if (position != std::streampos(-1)) stats->bytes = size_t(stream->tellp() - position);
+        measure(value, *stats, 0);
+    }
+
+    auto bytes = position != std::streampos(-1) ? size_t(stream->tellp() - position) : 0;
+    return call(Result{error, 0}, bytes);
+}
+
+Result write(const Value &value, std::string &data, Mode mode, Stats *stats)
+{
+    Metrics::Call call(Metrics::Operation::Write);
+    std::ostringstream stream;
+    auto result = write(value, &stream, mode, stats);
+    {
+        Traced(Flush);
+        data = stream.str();
+    }
+    if (stats) stats->bytes = data.size();
+    return call(result, data.size());
+}
+
+Result fwrite(const Value &value, const std::string &path, Mode mode, Stats *stats)
+{
+    Metrics::Call call(Metrics::Operation::FWrite);
+    if (stats) *stats = Stats{};
+    auto start = stats ? now() : 0;
+    std::ofstream stream;
+    {
+        Traced(FileIO);
+        stream.open(path);
+        if (!stream.is_open()) return call(Result{Error::FileIOError, 0}, 0);
+    }
+    auto io = stats ? now() - start : 0;
+
+    auto result = write(value, &stream, mode, stats);
+    start = stats ? now() : 0;
+    auto bytes = size_t(stream.tellp());
+    {
+        Traced(Flush);
+        stream.close();
+    }
+    if (stats) stats->io = io + now() - start;
+    return call(result, bytes);
+}
+
+Elements::Elements(std::istream &stream, const Policy &policy)
+    : _stream(&stream), _policy(policy), _result{Error::None, 0}, _begin(0), _scan(0), _depth(0), _offset(0),
+      _quoted(false), _escaped(false), _eof(false), _state(State::Open)
+{
+}
+
+Elements::Elements(const std::string &path, const Policy &policy)
+    : _stream(nullptr), _policy(policy), _result{Error::None, 0}, _begin(0), _scan(0), _depth(0), _offset(0),
+      _quoted(false), _escaped(false), _eof(false), _state(State::Open)
+{
+    Traced(FileIO);
+    _file.reset(new std::ifstream(path, std::ios::binary));
+    _stream = _file.get();
+    if (!_file->is_open()) stop(Error::FileIOError, 0);
+}
+
+Elements::~Elements() = default;
+
+bool Elements::fill()
+{
+    if (_eof) return false;
+    Traced(FileIO);
+    _buffer.erase(0, _begin);
+    _offset += _begin;
+    _scan -= _begin;
+    _begin = 0;
+
+    const size_t chunk = 1 << 16;
+    auto size = _buffer.size();
+    _buffer.resize(size + chunk);
+    _stream->read(&_buffer[size], chunk);
+    _buffer.resize(size + size_t(_stream->gcount()));
+    _eof = _buffer.size() == size;
+    return !_eof;
+}
+
+bool Elements::skip()
+{
+    while (true)
+    {
+        for (; _begin < _buffer.size(); ++_begin)
+        {
+            auto chr = _buffer[_begin];
+            if (chr != ' ' && chr != '\n' && chr != '\r' && chr != '\t') return true;
+        }
+        if (!fill()) return false;
+    }
+}
+
+bool Elements::stop(Error error, size_t index)
+{
+    _result = Result{error, index};
+    _state = State::Done;
+    return false;
+}
+
+bool Elements::next(Value &value)
+{
+    if (_state == State::Open)
+    {
+        if (!skip() || _buffer[_begin] != '[') return stop(Error::ExpectedBracketOpen, _offset + _begin);
+        ++_begin;
+        if (!skip()) return stop(Error::ExpectedBracketClose, _offset + _begin);
+        _state = State::Element;
+        if (_buffer[_begin] == ']') ++_begin, _state = State::Tail;
+        _scan = _begin;
+    }
+    if (_state == State::Tail)
+    {
+        if (skip()) return stop(Error::FailedToReachEnd, _offset + _begin);
+        return stop(Error::None, _offset + _begin);
+    }
+    if (_state == State::Done) return false;
+
+    // Finds the comma or bracket that ends the element outside of its strings and nested containers.
+    while (true)
+    {
+        for (; _scan < _buffer.size(); ++_scan)
+        {
+            auto chr = _buffer[_scan];
+            if (_quoted)
+            {
+                if (_escaped)
+                    _escaped = false;
+                else if (chr == '\\')
+                    _escaped = true;
+                else if (chr == '"')
+                    _quoted = false;
+            }
+            else if (chr == '"')
+                _quoted = true;
+            else if (chr == '[' || chr == '{')
+                ++_depth;
+            else if ((chr == ']' || chr == '}') && _depth != 0)
+                --_depth;
+            else if ((chr == ',' || chr == ']') && _depth == 0)
+                break;
+        }
+        if (_scan < _buffer.size()) break;
+        if (!fill()) return stop(Error::ExpectedCommaOrBracketClose, _offset + _buffer.size());
+    }
+
+    auto delimiter = _buffer[_scan];
+    _buffer[_scan] = '\0';
+    auto result = read(value, &_buffer[_begin], _policy);
+    _buffer[_scan] = delimiter;
+    if (result.error == Error::None && result.index != _scan - _begin) result.error = Error::ExpectedCommaOrBracketClose;
+    if (result.error != Error::None) return stop(result.error, _offset + _begin + result.index);
+
+    _begin = _scan = _scan + 1;
+    if (delimiter == ']') _state = State::Tail;
+    _result.index = _offset + _begin;
+    return true;
+}
+
+DocumentStream::DocumentStream(const char *data, const Policy &policy)
+    : _data(data), _size(strlen(data)), _stream(nullptr), _policy(policy), _result{Error::None, 0}, _range{0, 0},
+      _begin(0), _scan(0), _depth(0), _offset(0), _quoted(false), _escaped(false), _eof(true)
+{
+}
+
+DocumentStream::DocumentStream(const std::string &data, const Policy &policy)
+    : _data(data.c_str()), _size(data.size()), _stream(nullptr), _policy(policy), _result{Error::None, 0},
+      _range{0, 0}, _begin(0), _scan(0), _depth(0), _offset(0), _quoted(false), _escaped(false), _eof(true)
+{
+}
+
+DocumentStream::DocumentStream(std::istream &stream, const Policy &policy)
+    : _data(nullptr), _size(0), _stream(&stream), _policy(policy), _result{Error::None, 0}, _range{0, 0}, _begin(0),
+      _scan(0), _depth(0), _offset(0), _quoted(false), _escaped(false), _eof(false)
+{
+    _data = _buffer.c_str();
+}
+
+bool DocumentStream::fill()
+{
+    if (_eof) return false;
+    Traced(FileIO);
+    _buffer.erase(0, _begin);
+    _offset += _begin;
+    _scan -= _begin;
+    _begin = 0;
+
+    const size_t chunk = 1 << 16;
+    auto size = _buffer.size();
+    _buffer.resize(size + chunk);
+    _stream->read(&_buffer[size], chunk);
+    _buffer.resize(size + size_t(_stream->gcount()));
+    _data = _buffer.c_str();
+    _size = _buffer.size();
+    _eof = _size == size;
+    return !_eof;
+}
+
+bool DocumentStream::separate()
+{
+    while (true)
+    {
+        for (; _begin < _size; ++_begin)
+        {
+            auto chr = _data[_begin];
+            if (chr != ' ' && chr != '\n' && chr != '\r' && chr != '\t' && chr != '\x1E') return true;
+        }
+        if (!fill()) return false;
+    }
+}
+
+// Finds the end of the document that starts at begin outside of its strings and containers. Numbers and literals end
+// at the first whitespace, record separator or structural character.
+bool DocumentStream::find(size_t &end)
+{
+    for (; _scan < _size; ++_scan)
+    {
+        auto chr = _data[_scan];
+        if (_quoted)
+        {
+            if (_escaped)
+                _escaped = false;
+            else if (chr == '\\')
+                _escaped = true;
+            else if (chr == '"' && (_quoted = false, _depth == 0))
+                return end = _scan + 1, true;
+        }
+        else if (_depth == 0 && _scan != _begin && strchr(" \n\r\t\x1E\"[]{},", chr) != NULL)
+            return end = _scan, true;
+        else if (chr == '"')
+            _quoted = true;
+        else if (chr == '[' || chr == '{')
+            ++_depth;
+        else if ((chr == ']' || chr == '}') && (_depth == 0 || --_depth == 0))
+            return end = _scan + 1, true;
+    }
+    return false;
+}
+
+bool DocumentStream::stop(Error error, size_t index)
+{
+    _result = Result{error, index};
+    return false;
+}
+
+bool DocumentStream::next(Value &value)
+{
+    if (_result.error != Error::None) return false;
+    if (!separate()) return stop(Error::None, _offset + _begin);
+
+    // Strings and streams find the end the same way so that both split the same bytes into the same documents.
+    size_t end;
+    _scan = _begin, _depth = 0, _quoted = _escaped = false;
+    while (!find(end))
+        if (!fill())
+        {
+            end = _size;
+            break;
+        }
+
+    // Only the buffer of streams is terminated after the document, strings are parsed in place.
+    auto terminated = end < _buffer.size();
+    auto last = terminated ? _buffer[end] : '\0';
+    if (terminated) _buffer[end] = '\0';
+    auto result = parse(value, _data + _begin, _policy, _counts);
+    if (terminated) _buffer[end] = last;
+
+    if (result.error == Error::None && _begin + result.index != end) result.error = Error::FailedToReachEnd;
+    if (result.error != Error::None) return stop(result.error, _offset + _begin + result.index);
+
+    _range = Range{_offset + _begin, _offset + end};
+    _begin = end;
+    _result.index = _offset + end;
+    return true;
+}
+
+LineIndex::LineIndex() : _size(0) {}
+
+Result LineIndex::build(const std::string &path, const std::string &key, size_t threads)
+{
+    *this = LineIndex();
+    std::unique_ptr<FILE, int (*)(FILE *)> file(fopen(path.c_str(), "rb"), fclose);
+    if (file == nullptr) return Result{Error::FileIOError, 0};
+    _size = sizeOf(file.get());
+    _key = key;
+
+    const uint64_t chunk = 1 << 20;
+#if defined(_WIN32)
+    threads = 1;
+#endif
+    if (threads == 0) threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    threads = size_t(std::max<uint64_t>(std::min<uint64_t>(threads, (_size + chunk - 1) / chunk), 1));
+    std::vector<Result> results(threads, Result{Error::None, 0});
+    auto run = [&](const std::function<void(size_t)> &function) -> Result {
+        Simd::kernels();
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; ++i) workers.emplace_back(function, i);
+        function(0);
+        for (auto &worker : workers) worker.join();
+        for (auto &result : results)
+            if (!result) return result;
+        return Result{Error::None, 0};
+    };
+
+    // Each thread finds the newlines of its share of the file with memchr which is vectorized by the C library, and
+    // whether the part of each line in its share has anything but whitespace so blank lines don't become records.
+    auto blank = [](const char *begin, const char *end) -> bool {
+        for (; begin != end; ++begin)
+            if (*begin != ' ' && *begin != '\t' && *begin != '\r') return false;
+        return true;
+    };
+    std::vector<std::vector<uint64_t>> newlines(threads);
+    std::vector<std::vector<bool>> filled(threads);
+    std::vector<char> tails(threads, 0);
+    auto result = run([&](size_t thread) {
+        std::string buffer(chunk, '\0');
+        uint64_t begin = _size * thread / threads, end = _size * (thread + 1) / threads;
+        auto content = false;
+        for (auto offset = begin; offset < end; offset += chunk)
+        {
+            auto size = size_t(std::min(chunk, end - offset));
+            if (readAt(file.get(), offset, &buffer[0], size) != size)
+            {
+                results[thread] = Result{Error::FileIOError, size_t(offset)};
+                return;
+            }
+            for (auto ptr = buffer.data(), last = ptr + size;; ++ptr)
+            {
+                auto newline = static_cast<const char *>(memchr(ptr, '\n', size_t(last - ptr)));
+                content = content || !blank(ptr, newline == NULL ? last : newline);
+                if (newline == NULL) break;
+                newlines[thread].push_back(offset + uint64_t(newline - buffer.data()));
+                filled[thread].push_back(content);
+                content = false, ptr = newline;
+            }
+        }
+        tails[thread] = content;
+    });
+    if (!result) return result;
+
+    // The first line of each share continues the last line of the previous shares.
+    uint64_t start = 0;
+    auto content = false;
+    auto add = [&](uint64_t end, bool filled) {
+        if (filled) _records.push_back(Range{size_t(start), size_t(end)});
+        start = end + 1, content = false;
+    };
+    for (size_t thread = 0; thread < threads; ++thread)
+    {
+        for (size_t i = 0; i < newlines[thread].size(); ++i) add(newlines[thread][i], content || filled[thread][i]);
+        content = content || tails[thread] != 0;
+    }
+    add(_size, content);
+    if (_key.empty()) return Result{Error::None, size_t(_size)};
+
+    // Each thread parses its share of the records in batches that are read at once.
+    _values.resize(_records.size());
+    result = run([&](size_t thread) {
+        std::string buffer;
+        Value value;
+        size_t first = _records.size() * thread / threads, last = _records.size() * (thread + 1) / threads;
+        for (size_t i = first; i < last;)
+        {
+            auto batch = i + 1;
+            while (batch < last && _records[batch].end - _records[i].begin <= chunk) ++batch;
+            auto offset = _records[i].begin;
+            buffer.resize(_records[batch - 1].end - offset);
+            if (readAt(file.get(), offset, &buffer[0], buffer.size()) != buffer.size())
+            {
+                results[thread] = Result{Error::FileIOError, offset};
+                return;
+            }
+
+            for (; i < batch; ++i)
+            {
+                auto begin = _records[i].begin - offset, end = _records[i].end - offset;
+                auto terminated = end < buffer.size();
+                auto next = terminated ? buffer[end] : '\0';
+                if (terminated) buffer[end] = '\0';
+                auto parsed = read(value, &buffer[begin]);
+                if (terminated) buffer[end] = next;
+
+                if (parsed.error == Error::None && parsed.index != end - begin) parsed.error = Error::FailedToReachEnd;
+                if (!parsed)
+                {
+                    results[thread] = Result{parsed.error, offset + begin + parsed.index};
+                    return;
+                }
+                auto member = value.find(_key);
+                if (member != nullptr) write(*member, _values[i]);
+            }
+        }
+    });
+    if (!result) return result;
+
+    for (size_t i = 0; i < _values.size(); ++i)
+        if (!_values[i].empty()) _lookup.emplace(_values[i], i);
+    return Result{Error::None, size_t(_size)};
+}
+
+Result LineIndex::save(const std::string &path) const
 {
-    Read('[', Error::ExpectedBracketOpen);
-    while (true)
-    {
-        Skip(Error::ExpectedBracketClose);
-        if (parser.ptr[0] == ']')
-        {
-            ++parser.ptr;
-            return Error::None;
-        }
+    Traced(FileIO);
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream.is_open()) return Result{Error::FileIOError, 0};
 
-        Value value;
-        auto error = readValue(value, parser);
-        if (error != Error::None) return error;
-        array.push_back(std::move(value));
-        Skip(Error::ExpectedCommaOrBracketClose) if (parser.ptr[0] != ']') Read(',', Error::ExpectedComma);
+    auto put = [&](uint64_t number) { stream.write(reinterpret_cast<const char *>(&number), sizeof(number)); };
+    stream.write("NEYSONLI", 8);
+    put(1), put(_size), put(_key.size());
+    stream.write(_key.data(), std::streamsize(_key.size()));
+    put(_records.size());
+    for (auto &record : _records) put(record.begin), put(record.end);
+    for (size_t i = 0; !_key.empty() && i < _values.size(); ++i)
+    {
+        put(_values[i].size());
+        stream.write(_values[i].data(), std::streamsize(_values[i].size()));
     }
-}
 
-Error readNumber(Value &number, Parser &parser)
-{
-    std::string string(parser.ptr, strspn(parser.ptr, "-+.eE0123456789"));
-    // clang-format off
-    if (string.find_first_of(".eE") == std::string::npos)
-        try{ number = std::stoll(string); } catch (...) { return Error::InvalidNumber; }
-    else try{ number = std::stod(string); } catch (...) { return Error::InvalidNumber; }
-    // clang-format on
-    parser.ptr += string.size();
-    return Error::None;
+    auto bytes = size_t(stream.tellp());
+    stream.close();
+    return Result{stream ? Error::None : Error::FileIOError, bytes};
 }
 
-Error readValue(Value &value, Parser &parser)
+Result LineIndex::load(const std::string &path)
 {
-    Skip(Error::ExpectedStart);
-    if (parser.ptr[0] == '{') return readObject(value.object({}), parser);
-    if (parser.ptr[0] == '[') return readArray(value.array({}), parser);
-    if (parser.ptr[0] == '\"') return readString(value.string({}), parser);
-    if (strchr("-+.0123456789", parser.ptr[0]) != NULL) return readNumber(value, parser);
-
-    if (strncmp(parser.ptr, "true", 4) == 0)
+    *this = LineIndex();
+    std::string data;
     {
-        parser.ptr += 4;
-        value = true;
-        return Error::None;
+        Traced(FileIO);
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream.is_open()) return Result{Error::FileIOError, 0};
+        data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
     }
-    if (strncmp(parser.ptr, "false", 5) == 0)
+
+    // Every read is checked against the remaining data so that corrupt files fail instead of allocating too much.
+    size_t offset = 8;
+    auto get = [&](uint64_t &number) -> bool {
+        if (data.size() - offset < sizeof(number)) return false;
+        memcpy(&number, &data[offset], sizeof(number));
+        offset += sizeof(number);
+        return true;
+    };
+    auto text = [&](std::string &string) -> bool {
+        uint64_t size;
+        if (!get(size) || data.size() - offset < size) return false;
+        string.assign(data, offset, size_t(size));
+        offset += size_t(size);
+        return true;
+    };
+
+    uint64_t version, count;
+    bool valid = data.size() >= 8 && data.compare(0, 8, "NEYSONLI") == 0 && get(version) && version == 1 &&
+                 get(_size) && text(_key) && get(count) && count <= (data.size() - offset) / 16;
+    for (uint64_t i = 0; valid && i < count; ++i)
     {
-        parser.ptr += 5;
-        value = false;
-        return Error::None;
+        uint64_t begin = 0, end = 0;
+        valid = get(begin) && get(end) && begin < end && end <= _size;
+        if (valid) _records.push_back(Range{size_t(begin), size_t(end)});
     }
-    if (strncmp(parser.ptr, "null", 4) == 0)
+    if (valid && !_key.empty())
     {
-        parser.ptr += 4;
-        value = Value();
-        return Error::None;
+        _values.resize(_records.size());
+        for (size_t i = 0; valid && i < _values.size(); ++i) valid = text(_values[i]);
+        for (size_t i = 0; valid && i < _values.size(); ++i)
+            if (!_values[i].empty()) _lookup.emplace(_values[i], i);
     }
-    return Error::UnexpectedValueStart;
+
+    if (valid && offset == data.size()) return Result{Error::None, offset};
+    *this = LineIndex();
+    return Result{Error::FileIOError, offset};
 }
 
-Error unfixString(String &string)
+size_t LineIndex::find(const Value &value) const
 {
-    String output;
-    output.reserve(string.size());
-    for (size_t i = 0; i < string.size(); ++i)
-    {
-        if ((string[i] & 0xF8) == 0xF0)
-        {
-            if (i + 4 > string.size()) return Error::InvalidString;
-            output.append(string.data() + i, 4);
-            i += 3;
-        }
-        else if ((string[i] & 0xF0) == 0xE0)
-        {
-            if (i + 3 > string.size()) return Error::InvalidString;
-            output.append(string.data() + i, 3);
-            i += 2;
-        }
-        else if ((string[i] & 0xE0) == 0xC0)
-        {
-            if (i + 2 > string.size()) return Error::InvalidString;
-            output.append(string.data() + i, 2);
-            i += 1;
-        }
-
-        else if (string[i] == '\"')
-            output.append("\\\"");
-        else if (string[i] == '\\')
-            output.append("\\\\");
-        else if (string[i] == '/')
-            output.append("\\/");
-        else if (string[i] == '\b')
-            output.append("\\b");
-        else if (string[i] == '\f')
-            output.append("\\f");
-        else if (string[i] == '\n')
-            output.append("\\n");
-        else if (string[i] == '\r')
-            output.append("\\r");
-        else if (string[i] == '\t')
-            output.append("\\t");
-
-        else if (string[i] < 10)
-            output.append("\\u000").push_back('0' + string[i]);
-        else if (string[i] < 16)
-            output.append("\\u000").push_back('A' + string[i] - 10);
-        else if (string[i] < 26)
-            output.append("\\u001").push_back('0' + string[i] - 16);
-        else if (string[i] < 32)
-            output.append("\\u001").push_back('A' + string[i] - 26);
+    std::string key;
+    write(value, key);
+    auto it = _lookup.find(key);
+    return it == _lookup.end() ? _records.size() : it->second;
+}
 
-        else
-            output.push_back(string[i]);
-    }
+LineReader::LineReader(const std::string &path, const LineIndex &index) : _index(&index), _file(NULL)
+{
+    Traced(FileIO);
+    _file = fopen(path.c_str(), "rb");
+    if (_file != NULL && sizeOf(_file) != index.bytes()) fclose(_file), _file = NULL;
+}
 
-    string = output;
-    return Error::None;
+LineReader::~LineReader()
+{
+    if (_file != NULL) fclose(_file);
 }
 
-Error writeString(String string, std::ostream *stream)
+Result LineReader::read(size_t index, Value &value, const Policy &policy)
 {
-    auto error = unfixString(string);
-    if (error != Error::None) return error;
-    *stream << '\"' << string << '\"';
-    return Error::None;
+    if (_file == NULL) return Result{Error::FileIOError, 0};
+    if (index >= _index->size()) return Result{Error::RecordNotFound, 0};
+
+    auto &range = _index->range(index);
+    _buffer.resize(range.end - range.begin);
+    if (readAt(_file, range.begin, &_buffer[0], _buffer.size()) != _buffer.size())
+        return Result{Error::FileIOError, range.begin};
+    auto result = IO::read(value, _buffer, policy);
+    result.index += range.begin;
+    return result;
 }
 
-Error writeReal(double number, std::ostream *stream)
+Result LineReader::find(const Value &key, Value &value, const Policy &policy)
 {
-    if (std::isnan(number) || std::isinf(number)) return Error::InvalidNumber;
-    *stream << std::setprecision(16) << number;
-    return Error::None;
+    auto index = _index->find(key);
+    if (index == _index->size()) return Result{Error::RecordNotFound, 0};
+    return read(index, value, policy);
 }
 
-Error writeValue(const Value &value, std::ostream *stream);
+StructuralIndex::StructuralIndex() : _size(0) {}
 
-Error writeObject(const Object &object, std::ostream *stream)
+bool StructuralIndex::add(char type, uint64_t offset, std::vector<size_t> &stack)
 {
-    size_t i = 0;
-    *stream << '{';
-    for (const auto &pair : object)
+    uint64_t link = 0;
+    if (type == '}' || type == ']')
     {
-        if (i++ != 0) *stream << ',';
-        auto error = writeString(pair.first, stream);
-        if (error != Error::None) return error;
-
-        *stream << ':';
-        error = writeValue(pair.second, stream);
-        if (error != Error::None) return error;
+        if (stack.empty() || _types[stack.back()] != (type == '}' ? '{' : '[')) return false;
+        link = stack.back();
+        _links[stack.back()] = _types.size();
+        stack.pop_back();
     }
+    if (type == '{' || type == '[') stack.push_back(_types.size());
 
-    *stream << '}';
-    return Error::None;
+    _offsets.push_back(offset);
+    _links.push_back(link);
+    _types.push_back(type);
+    return true;
 }
 
-Error writeArray(const Array &array, std::ostream *stream)
+Result StructuralIndex::build(const std::string &path)
 {
-    *stream << '[';
-    for (size_t i = 0; i < array.size(); ++i)
+    *this = StructuralIndex();
+    std::unique_ptr<FILE, int (*)(FILE *)> file(fopen(path.c_str(), "rb"), fclose);
+    if (file == nullptr) return Result{Error::FileIOError, 0};
+    _size = sizeOf(file.get());
+
+    std::vector<size_t> stack;
+    auto unclosed = [&]() -> Error {
+        if (stack.empty()) return Error::UnexpectedValueStart;
+        return _types[stack.back()] == '{' ? Error::ExpectedBraceClose : Error::ExpectedBracketClose;
+    };
+
+    const uint64_t chunk = 1 << 20;
+    auto simd = Simd::kernels();
+    std::string buffer;
+    bool quoted = false, escaped = false, scalar = false;
+    for (uint64_t offset = 0; offset < _size; offset += chunk)
     {
-        if (i != 0) *stream << ',';
-        auto error = writeValue(array[i], stream);
-        if (error != Error::None) return error;
+        buffer.resize(size_t(std::min(chunk, _size - offset)));
+        if (readAt(file.get(), offset, &buffer[0], buffer.size()) != buffer.size())
+            return Result{Error::FileIOError, size_t(offset)};
+
+        auto data = buffer.c_str();
+        for (size_t i = 0; i < buffer.size(); ++i)
+        {
+            if (quoted)
+            {
+                // The string kernel stops at quotes, backslashes and the null character at the end of the buffer.
+                if (escaped)
+                {
+                    escaped = false;
+                    continue;
+                }
+                i = size_t(simd->string(data + i) - data);
+                if (i < buffer.size() && data[i] == '\\') escaped = true;
+                if (i < buffer.size() && data[i] == '"') quoted = false, add('"', offset + i, stack);
+                continue;
+            }
+
+            auto chr = data[i];
+            auto structural =
+                chr == '{' || chr == '}' || chr == '[' || chr == ']' || chr == ':' || chr == ',' || chr == '"';
+            if (chr == ' ' || chr == '\n' || chr == '\r' || chr == '\t')
+                scalar = false;
+            else if (stack.empty() && !_types.empty() && (structural || !scalar))
+                return Result{Error::FailedToReachEnd, size_t(offset + i)};
+            else if (structural)
+            {
+                scalar = false, quoted = chr == '"';
+                if (!add(chr, offset + i, stack)) return Result{unclosed(), size_t(offset + i)};
+            }
+            else if (!scalar)
+                scalar = true, add('s', offset + i, stack);
+        }
     }
 
-    *stream << ']';
-    return Error::None;
+    if (quoted) return Result{Error::ExpectedQuoteClose, size_t(_size)};
+    if (!stack.empty()) return Result{unclosed(), size_t(_size)};
+    return Result{Error::None, size_t(_size)};
 }
 
-Error writeValue(const Value &value, std::ostream *stream)
+Result StructuralIndex::save(const std::string &path) const
 {
-    if (value.type() == Type::Object) return writeObject(value.object(), stream);
-    if (value.type() == Type::Array) return writeArray(value.array(), stream);
-    if (value.type() == Type::String) return writeString(value.string(), stream);
-    if (value.type() == Type::Real) return writeReal(value.real(), stream);
+    Traced(FileIO);
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream.is_open()) return Result{Error::FileIOError, 0};
 
-    if (value.type() == Type::Integer)
-        *stream << value.integer();
-    else if (value.type() == Type::Bool)
-        *stream << (value.boolean() ? "true" : "false");
-    else if (value.type() == Type::Null)
-        *stream << "null";
-    else
-        return Error::InvalidValueType;
-    return Error::None;
-}
+    // The links are not stored since they follow from the types, and the offsets are stored as the differences to
+    // the previous ones in seven bit groups, which takes one or two bytes for most of them.
+    std::string deltas;
+    deltas.reserve(_offsets.size() * 2);
+    for (size_t i = 0; i < _offsets.size(); ++i)
+        for (auto delta = _offsets[i] - (i == 0 ? 0 : _offsets[i - 1]);; delta >>= 7)
+        {
+            deltas.push_back(char((delta & 0x7F) | (delta >= 0x80 ? 0x80 : 0)));
+            if (delta < 0x80) break;
+        }
 
-Error writeValue(const Value &value, std::ostream *stream, size_t indent);
+    auto put = [&](const void *data, size_t size) { stream.write(static_cast<const char *>(data), std::streamsize(size)); };
+    uint64_t version = 2, count = _types.size();
+    put("NEYSONSI", 8), put(&version, 8), put(&_size, 8), put(&count, 8);
+    put(_types.data(), count), put(deltas.data(), deltas.size());
 
-Error writeObject(const Object &object, std::ostream *stream, size_t indent)
+    auto bytes = size_t(stream.tellp());
+    stream.close();
+    return Result{stream ? Error::None : Error::FileIOError, bytes};
+}
+
+Result StructuralIndex::load(const std::string &path)
 {
-    if (object.empty())
+    *this = StructuralIndex();
+    std::string data;
     {
-        *stream << "{}";
-        return Error::None;
+        Traced(FileIO);
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream.is_open()) return Result{Error::FileIOError, 0};
+        data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
     }
 
-    size_t i = 0;
-    *stream << "{\n";
-    for (const auto &pair : object)
+    uint64_t version = 0, count = 0, size = 0;
+    if (data.size() >= 32) memcpy(&version, &data[8], 8), memcpy(&size, &data[16], 8), memcpy(&count, &data[24], 8);
+    if (data.size() < 32 || data.compare(0, 8, "NEYSONSI") != 0 || version != 2 || count > (data.size() - 32) / 2)
+        return Result{Error::FileIOError, 0};
+
+    // The links are rebuilt from the types which also rejects files whose brackets don't match.
+    _size = size;
+    _offsets.reserve(size_t(count)), _links.reserve(size_t(count)), _types.reserve(size_t(count));
+    std::vector<size_t> stack;
+    auto types = &data[32];
+    size_t position = 32 + size_t(count);
+    uint64_t offset = 0;
+    auto valid = true;
+    for (size_t i = 0; valid && i < count; ++i)
     {
-        if (i++ != 0) *stream << ",\n";
-        *stream << std::string((indent + 1) * 4, ' ');
-        auto error = writeString(pair.first, stream);
-        if (error != Error::None) return error;
-
-        *stream << ": ";
-        error = writeValue(pair.second, stream, indent + 1);
-        if (error != Error::None) return error;
+        uint64_t delta = 0;
+        for (unsigned shift = 0; valid; shift += 7)
+        {
+            valid = position < data.size() && shift < 64;
+            auto byte = valid ? uint8_t(data[position++]) : uint8_t(0);
+            delta |= uint64_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) break;
+        }
+        valid = valid && (i == 0 || delta != 0) && delta < _size - offset;
+        offset += delta;
+        valid = valid && types[i] != '\0' && strchr("{}[]:,\"s", types[i]) != NULL && add(types[i], offset, stack);
     }
+    for (size_t i = 0; valid && i < count; ++i)
+        if (_types[i] == '"') valid = i + 1 < count && _types[i + 1] == '"', ++i;
+    valid = valid && stack.empty() && position == data.size() && (count == 0 || skip(0) == count);
+    if (valid) return Result{Error::None, data.size()};
 
-    *stream << '\n' << std::string(indent * 4, ' ') << '}';
-    return Error::None;
+    *this = StructuralIndex();
+    return Result{Error::FileIOError, 0};
 }
 
-Error writeArray(const Array &array, std::ostream *stream, size_t indent)
+size_t StructuralIndex::skip(size_t index) const
 {
-    if (array.empty())
+    auto type = _types[index];
+    if (type == '{' || type == '[') return link(index) + 1;
+    if (type == '"') return index + 2;
+    if (type == 's') return index + 1;
+    return index;
+}
+
+Range StructuralIndex::range(size_t index) const
+{
+    auto begin = size_t(_offsets[index]);
+    if (_types[index] != 's') return Range{begin, size_t(_offsets[skip(index) - 1] + 1)};
+    return Range{begin, size_t(index + 1 < size() ? _offsets[index + 1] : _size)};
+}
+
+StructuralReader::StructuralReader(const std::string &path, const StructuralIndex &index)
+    : _index(&index), _file(NULL), _cached(0)
+{
+    Traced(FileIO);
+    _file = fopen(path.c_str(), "rb");
+    if (_file != NULL && sizeOf(_file) != index.bytes()) fclose(_file), _file = NULL;
+}
+
+StructuralReader::~StructuralReader()
+{
+    if (_file != NULL) fclose(_file);
+}
+
+// Keys are small and close to each other so they are read through a cache of at least 64 KiB of the file.
+const char *StructuralReader::view(uint64_t begin, uint64_t end)
+{
+    if (begin >= _cached && end <= _cached + _cache.size()) return _cache.data() + (begin - _cached);
+
+    auto size = size_t(std::min<uint64_t>(std::max<uint64_t>(end - begin, 1 << 16), _index->bytes() - begin));
+    _cache.resize(size);
+    if (size < end - begin || readAt(_file, begin, &_cache[0], size) != size)
     {
-        *stream << "[]";
-        return Error::None;
+        _cache.clear();
+        return nullptr;
     }
+    _cached = begin;
+    return _cache.data();
+}
 
-    *stream << "[\n";
-    for (size_t i = 0; i < array.size(); ++i)
+Result StructuralReader::key(size_t index, std::string &key)
+{
+    auto begin = _index->offset(index), end = _index->offset(index + 1) + 1;
+    auto data = view(begin, end);
+    if (data == nullptr) return Result{Error::FileIOError, size_t(begin)};
+
+    // Keys are matched byte by byte, so unescaped control characters which JSON doesn't allow are rejected here and
+    // keys without escapes are copied as they are.
+    auto size = size_t(end - begin);
+    for (size_t i = 1; i + 1 < size; ++i)
+        if (uint8_t(data[i]) < 0x20) return Result{Error::InvalidString, size_t(begin) + i};
+    if (memchr(data, '\\', size) == NULL)
     {
-        if (i != 0) *stream << ",\n";
-        *stream << std::string((indent + 1) * 4, ' ');
-        auto error = writeValue(array[i], stream, indent + 1);
-        if (error != Error::None) return error;
+        key.assign(data + 1, size - 2);
+        return Result{Error::None, size_t(begin)};
     }
 
-    *stream << '\n' << std::string(indent * 4, ' ') << ']';
-    return Error::None;
+    Value value;
+    auto result = read(value, std::string(data, size_t(end - begin)));
+    if (!result) return Result{result.error, size_t(begin) + result.index};
+    key = std::move(value.string());
+    return Result{Error::None, size_t(begin)};
 }
 
-Error writeValue(const Value &value, std::ostream *stream, size_t indent)
+// Calls visit with the key (zero for arrays) and the value of each item of the container at index until it returns
+// false. The rest of the grammar that the index doesn't check is checked here.
+Result StructuralReader::walk(size_t index, const std::function<bool(size_t key, size_t value)> &visit)
 {
-    if (value.type() == Type::Object) return writeObject(value.object(), stream, indent);
-    if (value.type() == Type::Array) return writeArray(value.array(), stream, indent);
-    if (value.type() == Type::String) return writeString(value.string(), stream);
-    if (value.type() == Type::Real) return writeReal(value.real(), stream);
-
-    if (value.type() == Type::Integer)
-        *stream << value.integer();
-    else if (value.type() == Type::Bool)
-        *stream << (value.boolean() ? "true" : "false");
-    else if (value.type() == Type::Null)
-        *stream << "null";
-    else
-        return Error::InvalidValueType;
-    return Error::None;
+    auto &structure = *_index;
+    auto object = structure.type(index) == '{';
+    auto close = structure.link(index);
+    for (auto item = index + 1; item < close;)
+    {
+        auto key = object ? item : 0, value = object ? item + 3 : item;
+        auto offset = size_t(structure.offset(item));
+        if (object && structure.type(item) != '"') return Result{Error::ExpectedQuoteOpen, offset};
+        if (object && (item + 2 >= close || structure.type(item + 2) != ':')) return Result{Error::ExpectedColon, offset};
+        if (value >= close || structure.skip(value) == value) return Result{Error::UnexpectedValueStart, offset};
+
+        auto next = structure.skip(value);
+        if (next != close && structure.type(next) != ',')
+            return Result{object ? Error::ExpectedCommaOrBraceClose : Error::ExpectedCommaOrBracketClose,
+                          size_t(structure.offset(next))};
+        if (!visit(key, value)) break;
+        if (next != close && next + 1 == close) return Result{Error::UnexpectedValueStart, size_t(structure.offset(close))};
+        item = next + 1;
+    }
+    return Result{Error::None, size_t(structure.offset(index))};
 }
 
-namespace IO
-{
-Result read(Value &value, const char *str)
+Result StructuralReader::locate(const std::string &pointer, size_t &index)
 {
-    value.reset();
-    Parser parser{str};
-    auto error = readValue(value, parser);
-    parser.ptr += strspn(parser.ptr, " \t\r\n");
-    return Result{error, size_t(parser.ptr - str)};
+    if (_file == NULL) return Result{Error::FileIOError, 0};
+    if (_index->size() == 0 || (!pointer.empty() && pointer[0] != '/')) return Result{Error::PathNotFound, 0};
+
+    index = 0;
+    std::string segment, name;
+    for (size_t start = 1; start <= pointer.size();)
+    {
+        auto end = std::min(pointer.find('/', start), pointer.size());
+        segment.clear();
+        for (auto i = start; i < end; ++i)
+            if (pointer[i] == '~' && i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1'))
+                segment += pointer[++i] == '0' ? '~' : '/';
+            else
+                segment += pointer[i];
+        start = end + 1;
+
+        auto type = _index->type(index);
+        auto position = size_t(_index->offset(index));
+        auto digits = !segment.empty() && segment.size() <= 19 && (segment.size() == 1 || segment[0] != '0') &&
+                      segment.find_first_not_of("0123456789") == std::string::npos;
+        if ((type != '{' && type != '[') || (type == '[' && !digits)) return Result{Error::PathNotFound, position};
+
+        auto target = type == '[' ? strtoull(segment.c_str(), NULL, 10) : 0;
+        size_t count = 0, found = 0;
+        Result failure{Error::None, 0};
+        auto result = walk(index, [&](size_t key, size_t value) -> bool {
+            if (type == '[' && count++ != target) return true;
+            if (type == '{' && !(failure = this->key(key, name))) return false;
+            if (type == '{' && name != segment) return true;
+            found = value;
+            return false;
+        });
+        if (!result) return result;
+        if (!failure) return failure;
+        if (found == 0) return Result{Error::PathNotFound, position};
+        index = found;
+    }
+    return Result{Error::None, size_t(_index->offset(index))};
 }
 
-Result read(Value &value, const std::string &str)
+Result StructuralReader::range(const std::string &pointer, Range &range)
 {
-    auto result = read(value, str.c_str());
-    if (result.error == Error::None && result.index != str.size()) result.error = Error::FailedToReachEnd;
+    size_t index;
+    auto result = locate(pointer, index);
+    if (result) range = _index->range(index);
     return result;
 }
 
-Result fread(Value &value, const std::string &path)
+Result StructuralReader::extract(const std::string &pointer, Value &value, const Policy &policy)
 {
-    auto file = fopen(path.c_str(), "r");
-    if (file == NULL) return Result{Error::FileIOError, 0};
-
-    fseek(file, 0, SEEK_END);
-    std::string data(ftell(file), 0);
-    rewind(file);
-    fread(&data[0], 1, data.size(), file);
+    Range range;
+    auto result = this->range(pointer, range);
+    if (!result) return result;
+
+    _buffer.resize(range.end - range.begin);
+    if (readAt(_file, range.begin, &_buffer[0], _buffer.size()) != _buffer.size())
+        return Result{Error::FileIOError, range.begin};
+    result = read(value, _buffer, policy);
+    result.index += range.begin;
+    return result;
+}
 
-    fclose(file);
-    return read(value, data);
+Result StructuralReader::size(const std::string &pointer, size_t &size)
+{
+    size_t index;
+    auto result = locate(pointer, index);
+    if (!result) return result;
+    if (_index->type(index) != '{' && _index->type(index) != '[') return Result{Error::InvalidValueType, result.index};
+
+    size = 0;
+    auto walked = walk(index, [&](size_t, size_t) { return ++size, true; });
+    return walked ? result : walked;
 }
 
-Result write(const Value &value, std::ostream *stream, Mode mode)
+Result StructuralReader::keys(const std::string &pointer, std::vector<std::string> &keys)
 {
-    if (mode == Mode::Readable) return Result{writeValue(value, stream, 0), 0};
-    return Result{writeValue(value, stream), 0};
+    size_t index;
+    auto result = locate(pointer, index);
+    if (!result) return result;
+    if (_index->type(index) != '{') return Result{Error::InvalidValueType, result.index};
+
+    keys.clear();
+    Result failure{Error::None, 0};
+    auto walked = walk(index, [&](size_t key, size_t) {
+        keys.emplace_back();
+        return bool(failure = this->key(key, keys.back()));
+    });
+    if (!walked) return walked;
+    return failure ? result : failure;
 }
 
-Result write(const Value &value, std::string &data, Mode mode)
+Result forEachElement(std::istream &stream, const std::function<bool(Value &value)> &callback, const Policy &policy)
 {
-    std::ostringstream stream;
-    auto result = write(value, &stream, mode);
-    data = stream.str();
-    return result;
+    Elements elements(stream, policy);
+    Value value;
+    while (elements.next(value))
+        if (!callback(value)) break;
+    return elements.result();
 }
 
-Result fwrite(const Value &value, const std::string &path, Mode mode)
+Result forEachElement(const std::string &path, const std::function<bool(Value &value)> &callback,
+                      const Policy &policy)
 {
-    std::ofstream stream(path);
-    if (!stream.is_open()) return Result{Error::FileIOError, 0};
-    return write(value, &stream, mode);
+    Elements elements(path, policy);
+    Value value;
+    while (elements.next(value))
+        if (!callback(value)) break;
+    return elements.result();
 }
 }  // namespace IO
 
@@ -689,6 +2915,12 @@ std::ostream &operator<<(std::ostream &os, Error error)
     if (error == Error::ExpectedCommaOrBracketClose) return os << "ExpectedCommaOrBracketClose";
     if (error == Error::FailedToReachEnd) return os << "FailedToReachEnd";
     if (error == Error::UnexpectedValueStart) return os << "UnexpectedValueStart";
+    if (error == Error::DuplicateKey) return os << "DuplicateKey";
+    if (error == Error::InvalidEncoding) return os << "InvalidEncoding";
+    if (error == Error::DepthExceeded) return os << "DepthExceeded";
+    if (error == Error::RecordNotFound) return os << "RecordNotFound";
+    if (error == Error::PathNotFound) return os << "PathNotFound";
+    if (error == Error::AllocationRejected) return os << "AllocationRejected";
     return os << "Unknown";
 }
 
@@ -712,6 +2944,55 @@ std::ostream &operator<<(std::ostream &os, Mode mode)
     return os << "Unknown";
 }
 
+std::ostream &operator<<(std::ostream &os, IO::Numbers numbers)
+{
+    if (numbers == IO::Numbers::Lenient) return os << "Lenient";
+    if (numbers == IO::Numbers::Strict) return os << "Strict";
+    if (numbers == IO::Numbers::Integer) return os << "Integer";
+    return os << "Unknown";
+}
+
+std::ostream &operator<<(std::ostream &os, Metrics::Operation operation)
+{
+    if (operation == Metrics::Operation::Read) return os << "Read";
+    if (operation == Metrics::Operation::Write) return os << "Write";
+    if (operation == Metrics::Operation::FRead) return os << "FRead";
+    if (operation == Metrics::Operation::FWrite) return os << "FWrite";
+    return os << "Unknown";
+}
+
+std::ostream &operator<<(std::ostream &os, Metrics::Size size)
+{
+    if (size == Metrics::Size::Tiny) return os << "Tiny";
+    if (size == Metrics::Size::Small) return os << "Small";
+    if (size == Metrics::Size::Medium) return os << "Medium";
+    if (size == Metrics::Size::Large) return os << "Large";
+    if (size == Metrics::Size::Huge) return os << "Huge";
+    return os << "Unknown";
+}
+
+std::ostream &operator<<(std::ostream &os, Trace::Phase phase)
+{
+    if (phase == Trace::Phase::Read) return os << "Read";
+    if (phase == Trace::Phase::Write) return os << "Write";
+    if (phase == Trace::Phase::FileIO) return os << "FileIO";
+    if (phase == Trace::Phase::Scan) return os << "Scan";
+    if (phase == Trace::Phase::Build) return os << "Build";
+    if (phase == Trace::Phase::Decode) return os << "Decode";
+    if (phase == Trace::Phase::Number) return os << "Number";
+    if (phase == Trace::Phase::Flush) return os << "Flush";
+    return os << "Unknown";
+}
+
+std::ostream &operator<<(std::ostream &os, Simd::Level level)
+{
+    if (level == Simd::Level::Scalar) return os << "Scalar";
+    if (level == Simd::Level::SSE42) return os << "SSE42";
+    if (level == Simd::Level::AVX2) return os << "AVX2";
+    if (level == Simd::Level::AVX512) return os << "AVX512";
+    return os << "Unknown";
+}
+
 std::ostream &operator<<(std::ostream &os, const Value &value)
 {
     if (value == Type::Null) return os << "Null";
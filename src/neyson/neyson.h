@@ -35,10 +35,18 @@
 #include <neyson/config.h>
 
 #include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 /// The main namespace of the library.
@@ -65,6 +73,12 @@ enum class Error
     ExpectedCommaOrBracketClose,
     FailedToReachEnd,
     UnexpectedValueStart,
+    DuplicateKey,
+    InvalidEncoding,
+    DepthExceeded,
+    RecordNotFound,
+    PathNotFound,
+    AllocationRejected,
 };
 
 /// Type of the value that Value class holds.
@@ -92,6 +106,37 @@ struct Result
     inline operator bool() const { return error == Error::None; }
 };
 
+/// Statistics of a single read or write call which are only collected if a pointer is given to functions in IO namespace.
+struct Stats
+{
+    /// Number of bytes read from input or written to output.
+    size_t bytes;
+
+    /// Number of values of each type which is indexed by Type.
+    size_t values[7];
+
+    /// Maximum nesting depth of arrays and objects (zero for a single non-container value).
+    size_t depth;
+
+    /// Length of the largest string in bytes.
+    size_t string;
+
+    /// Number of elements of the largest array.
+    size_t array;
+
+    /// Number of members of the largest object.
+    size_t object;
+
+    /// Number of String, Array and Object payloads that are allocated for the document.
+    size_t allocations;
+
+    /// Nanoseconds spent on opening, reading, writing and flushing files.
+    uint64_t io;
+
+    /// Nanoseconds spent on parsing or writing JSON.
+    uint64_t process;
+};
+
 class Value;
 
 /// Floating-point JSON number that is used in this library.
@@ -121,28 +166,428 @@ enum class Mode
 /// Namespace that contains IO operations which are for reading and writing JSON values.
 namespace IO
 {
+/// Grammar of numbers that the reader accepts.
+enum class Numbers
+{
+    /// Accepts anything that the C library can convert, like a leading plus sign or dot.
+    Lenient,
+    /// Accepts only the numbers of the JSON grammar.
+    Strict,
+    /// Accepts only the integers of the JSON grammar.
+    Integer,
+};
+
+/// Rules of the reader that each have a specialized parser with the unused checks compiled out.
+struct Policy
+{
+    /// Grammar of the numbers.
+    Numbers numbers;
+
+    /// Whether objects may contain the same key more than once, in which case the first one is kept.
+    bool duplicates;
+
+    /// Whether strings are checked to be valid UTF-8.
+    bool validate;
+
+    /// Maximum nesting depth of arrays and objects, zero means unlimited.
+    size_t depth;
+
+    /// Whether the items of arrays and objects are counted in a pass before parsing to reserve their exact capacity.
+    bool reserve;
+
+    /// Constructs the policy, the defaults are the rules of the policy-less reader functions.
+    explicit Policy(Numbers numbers = Numbers::Lenient, bool duplicates = true, bool validate = false,
+                    size_t depth = 0, bool reserve = false)
+        : numbers(numbers), duplicates(duplicates), validate(validate), depth(depth), reserve(reserve)
+    {
+    }
+
+    /// Policy that accepts only RFC 8259 JSON with unique keys and at most 512 levels of nesting.
+    static Policy strict() { return Policy(Numbers::Strict, false, true, 512); }
+};
+
+/// Reader function that reads the string into value according to the policy.
+/// If stats is not null it is filled with statistics of the call.
+Result read(Value &value, const char *str, const Policy &policy, Stats *stats = nullptr);
+
+/// Reader function that reads the string into value according to the policy.
+/// If stats is not null it is filled with statistics of the call.
+Result read(Value &value, const std::string &str, const Policy &policy, Stats *stats = nullptr);
+
+/// Reader function that reads the file into value according to the policy.
+/// If stats is not null it is filled with statistics of the call.
+Result fread(Value &value, const std::string &path, const Policy &policy, Stats *stats = nullptr);
+
 /// Reader function that reads the string into value.
-Result read(Value &value, const char *str);
+/// If stats is not null it is filled with statistics of the call.
+Result read(Value &value, const char *str, Stats *stats = nullptr);
 
 /// Reader function that reads the string into value.
-Result read(Value &value, const std::string &str);
+/// If stats is not null it is filled with statistics of the call.
+Result read(Value &value, const std::string &str, Stats *stats = nullptr);
 
 /// Reader function that reads the file into value.
-Result fread(Value &value, const std::string &path);
+/// If stats is not null it is filled with statistics of the call.
+Result fread(Value &value, const std::string &path, Stats *stats = nullptr);
 
 /// Writer function that writes value to a string and returns it.
-Result write(const Value &value, std::string &data, Mode mode = Mode::Compact);
+/// If stats is not null it is filled with statistics of the call.
+Result write(const Value &value, std::string &data, Mode mode = Mode::Compact, Stats *stats = nullptr);
 
 /// Writer function that writes value to the given stream.
-Result write(const Value &value, std::ostream *stream, Mode mode = Mode::Compact);
+/// If stats is not null it is filled with statistics of the call.
+Result write(const Value &value, std::ostream *stream, Mode mode = Mode::Compact, Stats *stats = nullptr);
 
 /// Writer function that writes value to the given file path and returns success or failure.
-Result fwrite(const Value &value, const std::string &path, Mode mode = Mode::Compact);
+/// If stats is not null it is filled with statistics of the call.
+Result fwrite(const Value &value, const std::string &path, Mode mode = Mode::Compact, Stats *stats = nullptr);
 }  // namespace IO
 
+/// Namespace that contains the pool allocator which holds the String, Array and Object payloads of values.
+/// Each thread allocates from its own free lists and blocks freed by other threads are returned without locks.
+/// The pool is only compiled in if NEYSON_USE_POOL is defined, otherwise values use new and delete.
+namespace Pool
+{
+/// Statistics of the pool allocator which are summed over all threads.
+struct Stats
+{
+    /// Number of blocks that are allocated from the pool.
+    size_t allocations;
+
+    /// Number of blocks that are returned to the pool (including remote ones).
+    size_t deallocations;
+
+    /// Number of blocks that are returned to the pool by a thread other than their owner.
+    size_t remote;
+
+    /// Number of bytes in blocks that are currently in use.
+    size_t used;
+
+    /// Number of bytes that are requested from the system for the pool.
+    size_t reserved;
+
+    /// Number of chunks that are requested from the system for the pool.
+    size_t chunks;
+
+    /// Number of thread heaps that are created.
+    size_t heaps;
+};
+
+/// Enables or disables the pool at runtime and returns the previous state.
+/// Values allocated while the pool was in the other state are still freed correctly.
+bool enable(bool enabled);
+
+/// Returns true if the pool is compiled in and enabled.
+bool enabled();
+
+/// Returns statistics of the pool (all zero if the pool is not compiled in).
+Stats stats();
+}  // namespace Pool
+
+/// Namespace that contains hooks which observe the String, Array and Object payloads that values allocate and free.
+namespace Memory
+{
+/// Hooks that are called for every payload allocation and free of values, including values nested in arrays and objects.
+/// Either function can be null. The allocate hook rejects a payload (for example when a budget is exceeded) by returning
+/// false, in which case the payload is released without calling the deallocate hook. The parser then fails with
+/// AllocationRejected and everywhere else the rejection is an error like any other (an exception or abort). Hooks must
+/// not throw when the library is built with NEYSON_NO_EXCEPTIONS, otherwise exceptions are propagated after the
+/// payload is released.
+struct Hooks
+{
+    /// Function that is called after a payload of the given type and size is allocated at ptr, returns false to reject.
+    bool (*allocate)(void *ptr, size_t size, Type type, void *data);
+
+    /// Function that is called before the payload of the given type and size at ptr is freed (it must not throw).
+    void (*deallocate)(void *ptr, size_t size, Type type, void *data);
+
+    /// User data that is passed to the hook functions.
+    void *data;
+};
+
+/// Installs hooks for all threads and returns the previously installed ones (null removes the hooks).
+/// The hooks object must stay alive until it is replaced and no thread is calling it anymore.
+const Hooks *install(const Hooks *hooks);
+
+/// Returns the currently installed hooks or null.
+const Hooks *installed();
+}  // namespace Memory
+
+/// Namespace that contains process-wide metrics of the functions in IO namespace.
+/// Each thread records into its own counters without locks and the counters are merged when a snapshot is taken.
+namespace Metrics
+{
+/// Operations that are measured.
+enum class Operation
+{
+    Read,
+    Write,
+    FRead,
+    FWrite,
+};
+
+/// Size buckets of the input or output of operations which are below 1KiB, 16KiB, 256KiB, 4MiB and the rest.
+enum class Size
+{
+    Tiny,
+    Small,
+    Medium,
+    Large,
+    Huge,
+};
+
+/// Latency histogram in nanoseconds which has logarithmic buckets that are split into 8 linear sub-buckets.
+/// Values are recorded with at most 12.5% error and values larger than 2^40 are clamped.
+struct Histogram
+{
+    /// Number of buckets in the histogram.
+    static const size_t Buckets = 312;
+
+    /// Number of recorded values in each bucket.
+    uint64_t counts[Buckets];
+
+    /// Number of recorded values.
+    uint64_t count;
+
+    /// Sum of the recorded values.
+    uint64_t sum;
+
+    /// Constructor that creates an empty histogram.
+    Histogram();
+
+    /// Records the value in the histogram.
+    void record(uint64_t value);
+
+    /// Adds the values of the other histogram to this one.
+    void merge(const Histogram &other);
+
+    /// Returns the value at the given quantile (between 0 and 1) which is the upper bound of its bucket.
+    uint64_t quantile(double q) const;
+
+    /// Returns the average of the recorded values.
+    double mean() const;
+
+    /// Returns the upper bound of the largest recorded value.
+    uint64_t max() const;
+
+    /// Returns the bucket index of the value.
+    static size_t bucket(uint64_t value);
+
+    /// Returns the largest value that falls into the bucket.
+    static uint64_t upper(size_t bucket);
+};
+
+/// Metrics of an operation in a size bucket.
+struct Entry
+{
+    /// Number of calls.
+    uint64_t calls;
+
+    /// Number of calls that returned an error.
+    uint64_t errors;
+
+    /// Number of bytes read or written.
+    uint64_t bytes;
+
+    /// Latency of the calls in nanoseconds.
+    Histogram latency;
+};
+
+/// Merged metrics of all threads which is indexed by Operation and Size.
+struct Snapshot
+{
+    /// Metrics of each operation and size bucket.
+    Entry entries[4][5];
+
+    /// Returns the metrics of the operation and size bucket.
+    inline const Entry &operator()(Operation operation, Size size) const { return entries[int(operation)][int(size)]; }
+};
+
+/// Enables or disables recording (disabled by default) and returns the previous state.
+bool enable(bool enabled);
+
+/// Returns true if recording is enabled.
+bool enabled();
+
+/// Returns the size bucket of the given number of bytes.
+Size size(size_t bytes);
+
+/// Returns the metrics recorded by all threads since the start or the last reset.
+Snapshot snapshot();
+
+/// Returns the snapshot as a JSON object which can be published (empty buckets are omitted).
+Value report(const Snapshot &snapshot);
+
+/// Makes the following snapshots start from zero.
+void reset();
+}  // namespace Metrics
+
+/// Namespace that contains tracing of the phases of reading and writing which are dumped as Chrome trace events.
+/// Tracing is only compiled in if NEYSON_USE_TRACE is defined and costs a single check per phase when it is stopped.
+namespace Trace
+{
+/// Phases that are traced.
+enum class Phase
+{
+    /// Whole IO::read call.
+    Read,
+    /// Whole IO::write call.
+    Write,
+    /// Opening, reading and closing files.
+    FileIO,
+    /// Scanning a string for its closing quote.
+    Scan,
+    /// Building an array or object value.
+    Build,
+    /// Decoding escape sequences of a string.
+    Decode,
+    /// Converting a number.
+    Number,
+    /// Flushing output to its destination.
+    Flush,
+};
+
+/// Starts recording events into a ring buffer that keeps the last capacity events.
+void start(size_t capacity = 65536);
+
+/// Stops recording events (the recorded events are kept until the next start).
+void stop();
+
+/// Returns true if events are being recorded.
+bool enabled();
+
+/// Returns the recorded events as a Chrome trace-event JSON document that can be loaded in chrome://tracing.
+Value dump();
+
+/// Writes the recorded events as a Chrome trace-event JSON document to the given file path.
+Result fdump(const std::string &path);
+}  // namespace Trace
+
+/// Namespace that contains the selection of the vectorized kernels used for skipping whitespace, scanning strings,
+/// finding characters to escape, validating UTF-8 and scanning numbers. The best level supported by the processor
+/// is chosen once through cpuid unless the NEYSON_SIMD environment variable (scalar, sse4.2, avx2 or avx512) or
+/// select() forces another one. Only x86 processors have vectorized kernels, others always use the scalar ones.
+namespace Simd
+{
+/// Instruction set levels of the kernels.
+enum class Level
+{
+    /// Portable kernels without vector instructions.
+    Scalar,
+    /// Kernels with 16 byte SSE4.2 vectors.
+    SSE42,
+    /// Kernels with 32 byte AVX2 vectors.
+    AVX2,
+    /// Kernels with 64 byte AVX-512 (F and BW) vectors.
+    AVX512,
+};
+
+/// Returns the best level supported by the processor and the operating system.
+Level supported();
+
+/// Returns the level of the kernels in use.
+Level level();
+
+/// Uses the kernels of the given level (lowered to the supported level) and returns the level in use.
+/// Should not be called while other threads are reading or writing.
+Level select(Level level);
+
+/// Returns true if the data is valid UTF-8 (without overlong forms, surrogates or code points above U+10FFFF).
+bool validate(const char *data, size_t size);
+}  // namespace Simd
+
+/// Namespace that contains the type traits of the generic conversions between values and C++ types.
+namespace Convert
+{
+template <typename...>
+struct Void
+{
+    typedef void type;
+};
+
+/// True if T can be iterated, sized and inserted into like the standard sequence and set containers.
+template <typename T, typename = void>
+struct Sequence : std::false_type
+{
+};
+
+template <typename T>
+struct Sequence<T, typename Void<typename T::value_type, decltype(std::declval<T &>().size()),
+                                 decltype(std::declval<T &>().insert(std::declval<T &>().end(),
+                                                                     std::declval<typename T::value_type>()))>::type>
+    : std::integral_constant<bool, !std::is_same<T, String>::value>
+{
+};
+
+/// True if T is a standard map container whose keys can be constructed from String.
+template <typename T, typename = void>
+struct Map : std::false_type
+{
+};
+
+template <typename T>
+struct Map<T, typename Void<typename T::key_type, typename T::mapped_type>::type>
+    : std::is_constructible<typename T::key_type, String>
+{
+};
+
+/// True if T has a reserve function like std::vector.
+template <typename T, typename = void>
+struct Reservable : std::false_type
+{
+};
+
+template <typename T>
+struct Reservable<T, typename Void<decltype(std::declval<T &>().reserve(size_t()))>::type> : std::true_type
+{
+};
+
+/// Kind of the C++ type which selects how it is converted.
+enum class Kind
+{
+    Value,
+    Bool,
+    Integral,
+    Floating,
+    String,
+    Sequence,
+    Map,
+    Unsupported,
+};
+
+/// Returns the kind of the C++ type.
+template <typename T>
+constexpr Kind kind()
+{
+    return std::is_same<T, Value>::value        ? Kind::Value
+           : std::is_same<T, bool>::value       ? Kind::Bool
+           : std::is_integral<T>::value         ? Kind::Integral
+           : std::is_floating_point<T>::value   ? Kind::Floating
+           : std::is_same<T, String>::value     ? Kind::String
+           : Map<T>::value                      ? Kind::Map
+           : Sequence<T>::value                 ? Kind::Sequence
+                                                : Kind::Unsupported;
+}
+
+/// True if values can be constructed from T by the generic container constructor (Array and Object have their own).
+template <typename T>
+struct Container
+    : std::integral_constant<bool, (kind<T>() == Kind::Sequence || kind<T>() == Kind::Map) &&
+                                       !std::is_same<T, Array>::value && !std::is_same<T, Object>::value>
+{
+};
+
+/// Converter between values and the C++ type which is specialized for each kind.
+template <typename T, Kind K = kind<T>()>
+struct Codec;
+}  // namespace Convert
+
 /// Value class that can hold any of the JSON types.
 class Value
 {
+    template <typename T, Convert::Kind K>
+    friend struct Convert::Codec;
+
     union Variant
     {
         bool b;
@@ -156,6 +601,10 @@ class Value
     Type _type;
     Variant _value;
 
+    /// Throws the runtime exception (or aborts with NEYSON_NO_EXCEPTIONS) of accessing the value as the requested
+    /// type while it holds another one.
+    [[noreturn]] void mismatch(Type requested) const;
+
 public:
     /// Default constructor.
     Value();
@@ -164,7 +613,7 @@ public:
     ~Value();
 
     /// Move constructor.
-    Value(Value &&val);
+    Value(Value &&val) noexcept;
 
     /// Copy constructor.
     Value(const Value &val);
@@ -173,7 +622,7 @@ public:
     Value(const char *val);
 
     /// Move assignment operator
-    Value &operator=(Value &&val);
+    Value &operator=(Value &&val) noexcept;
 
     /// Copy assignment operator
     Value &operator=(const Value &val);
@@ -199,6 +648,18 @@ public:
     /// Conversion operator that converts the holding type to String.
     operator String() const;
 
+    /// Converts the holding type to bool like the conversion operator and returns false if it is not convertible.
+    bool convert(bool &val) const;
+
+    /// Converts the holding type to Integer like the conversion operator and returns false if it is not convertible.
+    bool convert(Integer &val) const;
+
+    /// Converts the holding type to Real like the conversion operator and returns false if it is not convertible.
+    bool convert(Real &val) const;
+
+    /// Converts the holding type to String like the conversion operator and returns false if it is not convertible.
+    bool convert(String &val) const;
+
     /// Comparison operator that returns true if the type is the same as type arguement otherwise false.
     inline bool operator==(Type type) const { return _type == type; }
 
@@ -237,6 +698,41 @@ public:
     /// If the type of the value is not object an runtime exception is thrown.
     const Value &operator[](const std::string &name) const;
 
+    /// Lookup function that returns a pointer to the value of object where key is name arguement.
+    /// Returns nullptr if the type of the value is not object or the object doesn't have the key.
+    Value *find(const std::string &name);
+
+    /// Constructs an item at the end of the array in place from the arguments and returns a reference to it.
+    /// Null values become empty arrays first, if the type of the value is not array an runtime exception is thrown.
+    template <typename... Args>
+    Value &emplace_back(Args &&... args)
+    {
+        auto &array = _type == Type::Null ? this->array({}) : this->array();
+        array.emplace_back(std::forward<Args>(args)...);
+        return array.back();
+    }
+
+    /// Constructs the key and the value of an object member in place from the arguments and returns a reference to
+    /// the value. If the key already exists the value is left unchanged. Null values become empty objects first, if the
+    /// type of the value is not object an runtime exception is thrown.
+    template <typename K, typename... Args>
+    Value &emplace(K &&key, Args &&... args)
+    {
+        auto &object = _type == Type::Null ? this->object({}) : this->object();
+        return object
+            .emplace(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                     std::forward_as_tuple(std::forward<Args>(args)...))
+            .first->second;
+    }
+
+    /// Reserves room for size items in the array or members in the object.
+    /// If the type of the value is not array or object an runtime exception is thrown.
+    void reserve(size_t size);
+
+    /// Lookup function that returns a constant pointer to the value of object where key is name arguement.
+    /// Returns nullptr if the type of the value is not object or the object doesn't have the key.
+    const Value *find(const std::string &name) const;
+
     /// Constructor that takes value of arithmetic type and sets the value to it by copying.
     template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
     Value(const T &val)
@@ -291,11 +787,27 @@ public:
 
     /// Getter function that returns a reference to the bool type that this class is holding.
     /// If the type that this class holds is not bool the function throws a runtime exception.
-    bool &boolean();
+    inline bool &boolean()
+    {
+        if (_type != Type::Bool) mismatch(Type::Bool);
+        return _value.b;
+    }
 
     /// Getter function that returns a constant reference to the bool type that this class is holding.
     /// If the type that this class holds is not bool the function throws a runtime exception.
-    const bool &boolean() const;
+    inline const bool &boolean() const
+    {
+        if (_type != Type::Bool) mismatch(Type::Bool);
+        return _value.b;
+    }
+
+    /// Getter function that returns a pointer to the bool type that this class is holding.
+    /// If the type that this class holds is not bool the function returns nullptr.
+    inline bool *booleanIf() { return _type == Type::Bool ? &_value.b : nullptr; }
+
+    /// Getter function that returns a constant pointer to the bool type that this class is holding.
+    /// If the type that this class holds is not bool the function returns nullptr.
+    inline const bool *booleanIf() const { return _type == Type::Bool ? &_value.b : nullptr; }
 
     /// Constructor that takes Integer and sets the value to it by moving.
     Value(Integer &&val);
@@ -317,11 +829,27 @@ public:
 
     /// Getter function that returns a reference to the Integer type that this class is holding.
     /// If the type that this class holds is not Integer the function throws a runtime exception.
-    Integer &integer();
+    inline Integer &integer()
+    {
+        if (_type != Type::Integer) mismatch(Type::Integer);
+        return _value.i;
+    }
 
     /// Getter function that returns a constant reference to the Integer type that this class is holding.
     /// If the type that this class holds is not Integer the function throws a runtime exception.
-    const Integer &integer() const;
+    inline const Integer &integer() const
+    {
+        if (_type != Type::Integer) mismatch(Type::Integer);
+        return _value.i;
+    }
+
+    /// Getter function that returns a pointer to the Integer type that this class is holding.
+    /// If the type that this class holds is not Integer the function returns nullptr.
+    inline Integer *integerIf() { return _type == Type::Integer ? &_value.i : nullptr; }
+
+    /// Getter function that returns a constant pointer to the Integer type that this class is holding.
+    /// If the type that this class holds is not Integer the function returns nullptr.
+    inline const Integer *integerIf() const { return _type == Type::Integer ? &_value.i : nullptr; }
 
     /// Constructor that takes Real and sets the value to it by moving.
     Value(Real &&val);
@@ -343,11 +871,27 @@ public:
 
     /// Getter function that returns a reference to the Real type that this class is holding.
     /// If the type that this class holds is not Real the function throws a runtime exception.
-    Real &real();
+    inline Real &real()
+    {
+        if (_type != Type::Real) mismatch(Type::Real);
+        return _value.r;
+    }
 
     /// Getter function that returns a constant reference to the Real type that this class is holding.
     /// If the type that this class holds is not Real the function throws a runtime exception.
-    const Real &real() const;
+    inline const Real &real() const
+    {
+        if (_type != Type::Real) mismatch(Type::Real);
+        return _value.r;
+    }
+
+    /// Getter function that returns a pointer to the Real type that this class is holding.
+    /// If the type that this class holds is not Real the function returns nullptr.
+    inline Real *realIf() { return _type == Type::Real ? &_value.r : nullptr; }
+
+    /// Getter function that returns a constant pointer to the Real type that this class is holding.
+    /// If the type that this class holds is not Real the function returns nullptr.
+    inline const Real *realIf() const { return _type == Type::Real ? &_value.r : nullptr; }
 
     /// Constructor that takes String and sets the value to it by moving.
     Value(String &&val);
@@ -369,11 +913,27 @@ public:
 
     /// Getter function that returns a reference to the String type that this class is holding.
     /// If the type that this class holds is not String the function throws a runtime exception.
-    String &string();
+    inline String &string()
+    {
+        if (_type != Type::String) mismatch(Type::String);
+        return *_value.s;
+    }
 
     /// Getter function that returns a constant reference to the String type that this class is holding.
     /// If the type that this class holds is not String the function throws a runtime exception.
-    const String &string() const;
+    inline const String &string() const
+    {
+        if (_type != Type::String) mismatch(Type::String);
+        return *_value.s;
+    }
+
+    /// Getter function that returns a pointer to the String type that this class is holding.
+    /// If the type that this class holds is not String the function returns nullptr.
+    inline String *stringIf() { return _type == Type::String ? _value.s : nullptr; }
+
+    /// Getter function that returns a constant pointer to the String type that this class is holding.
+    /// If the type that this class holds is not String the function returns nullptr.
+    inline const String *stringIf() const { return _type == Type::String ? _value.s : nullptr; }
 
     /// Constructor that takes Array and sets the value to it by moving.
     Value(Array &&val);
@@ -395,11 +955,27 @@ public:
 
     /// Getter function that returns a reference to the Array type that this class is holding.
     /// If the type that this class holds is not Array the function throws a runtime exception.
-    Array &array();
+    inline Array &array()
+    {
+        if (_type != Type::Array) mismatch(Type::Array);
+        return *_value.a;
+    }
 
     /// Getter function that returns a constant reference to the Array type that this class is holding.
     /// If the type that this class holds is not Array the function throws a runtime exception.
-    const Array &array() const;
+    inline const Array &array() const
+    {
+        if (_type != Type::Array) mismatch(Type::Array);
+        return *_value.a;
+    }
+
+    /// Getter function that returns a pointer to the Array type that this class is holding.
+    /// If the type that this class holds is not Array the function returns nullptr.
+    inline Array *arrayIf() { return _type == Type::Array ? _value.a : nullptr; }
+
+    /// Getter function that returns a constant pointer to the Array type that this class is holding.
+    /// If the type that this class holds is not Array the function returns nullptr.
+    inline const Array *arrayIf() const { return _type == Type::Array ? _value.a : nullptr; }
 
     /// Constructor that takes Object and sets the value to it by moving.
     Value(Object &&val);
@@ -421,12 +997,579 @@ public:
 
     /// Getter function that returns a reference to the Object type that this class is holding.
     /// If the type that this class holds is not Object the function throws a runtime exception.
-    Object &object();
+    inline Object &object()
+    {
+        if (_type != Type::Object) mismatch(Type::Object);
+        return *_value.o;
+    }
 
     /// Getter function that returns a constant reference to the Object type that this class is holding.
     /// If the type that this class holds is not Object the function throws a runtime exception.
-    const Object &object() const;
+    inline const Object &object() const
+    {
+        if (_type != Type::Object) mismatch(Type::Object);
+        return *_value.o;
+    }
+
+    /// Getter function that returns a pointer to the Object type that this class is holding.
+    /// If the type that this class holds is not Object the function returns nullptr.
+    inline Object *objectIf() { return _type == Type::Object ? _value.o : nullptr; }
+
+    /// Getter function that returns a constant pointer to the Object type that this class is holding.
+    /// If the type that this class holds is not Object the function returns nullptr.
+    inline const Object *objectIf() const { return _type == Type::Object ? _value.o : nullptr; }
+
+    /// Constructor that takes a standard sequence, set or map (with string keys) container and converts its items.
+    /// Items are moved if the container is an rvalue.
+    template <typename T,
+              typename = typename std::enable_if<Convert::Container<typename std::decay<T>::type>::value>::type>
+    Value(T &&val) : _type(Type::Null)
+    {
+        _value.i = 0;
+        Convert::Codec<typename std::decay<T>::type>::put(*this, std::forward<T>(val));
+    }
+
+    /// Assignment operator that takes a standard sequence, set or map (with string keys) container and converts its
+    /// items. Items are moved if the container is an rvalue.
+    template <typename T,
+              typename = typename std::enable_if<Convert::Container<typename std::decay<T>::type>::value>::type>
+    Value &operator=(T &&val)
+    {
+        reset();
+        Convert::Codec<typename std::decay<T>::type>::put(*this, std::forward<T>(val));
+        return *this;
+    }
+
+    /// Converts the value to T which is Value, an arithmetic type, String or a standard container of them.
+    /// Scalars convert like the conversion operators and containers require the value to be array or object.
+    template <typename T>
+    T as() const &
+    {
+        return Convert::Codec<T>::get(*this);
+    }
+
+    /// Converts the value to T like the other overload but moves the strings and values out of this value.
+    template <typename T>
+    T as() &&
+    {
+        return Convert::Codec<T>::take(std::move(*this));
+    }
+};
+
+/// Namespace that contains the builders of documents from nested initializer lists.
+namespace Build
+{
+/// Item of the array builder. Values are moved out of it since the items of initializer lists are constant.
+struct Item
+{
+    mutable Value value;
+
+    /// Constructor that constructs the value from the argument.
+    template <typename T>
+    Item(T &&value) : value(std::forward<T>(value))
+    {
+    }
+};
+
+/// Member of the object builder. Keys and values are moved out of it since the items of initializer lists are
+/// constant.
+struct Member
+{
+    mutable String key;
+    mutable Value value;
+
+    /// Constructor that constructs the key and the value from the arguments.
+    template <typename K, typename T>
+    Member(K &&key, T &&value) : key(std::forward<K>(key)), value(std::forward<T>(value))
+    {
+    }
+};
+
+/// Builds an array value with exactly the room for the items.
+inline Value array(std::initializer_list<Item> items)
+{
+    Value value;
+    auto &array = value.array({});
+    array.reserve(items.size());
+    for (auto &item : items) array.push_back(std::move(item.value));
+    return value;
+}
+
+/// Builds an object value with exactly the room for the members, for duplicate keys the first one is kept.
+inline Value object(std::initializer_list<Member> members)
+{
+    Value value;
+    auto &object = value.object({});
+    object.reserve(members.size());
+    for (auto &member : members) object.emplace(std::move(member.key), std::move(member.value));
+    return value;
+}
+}  // namespace Build
+
+namespace Convert
+{
+template <typename T>
+struct Codec<T, Kind::Value>
+{
+    static T get(const Value &value) { return value; }
+    static T take(Value &&value) { return std::move(value); }
+};
+
+template <typename T>
+struct Codec<T, Kind::Bool>
+{
+    static T get(const Value &value) { return value._type == Type::Bool ? value._value.b : bool(value); }
+    static T take(Value &&value) { return get(value); }
+};
+
+template <typename T>
+struct Codec<T, Kind::Integral>
+{
+    static T get(const Value &value) { return T(value._type == Type::Integer ? value._value.i : Integer(value)); }
+    static T take(Value &&value) { return get(value); }
+};
+
+template <typename T>
+struct Codec<T, Kind::Floating>
+{
+    static T get(const Value &value) { return T(value._type == Type::Real ? value._value.r : Real(value)); }
+    static T take(Value &&value) { return get(value); }
+};
+
+template <typename T>
+struct Codec<T, Kind::String>
+{
+    static T get(const Value &value) { return value; }
+    static T take(Value &&value) { return value._type == Type::String ? std::move(*value._value.s) : get(value); }
+};
+
+template <typename T>
+struct Codec<T, Kind::Sequence>
+{
+    typedef typename T::value_type Item;
+
+    template <typename C, typename std::enable_if<Reservable<C>::value, int>::type = 0>
+    static void reserve(C &container, size_t size)
+    {
+        container.reserve(size);
+    }
+
+    template <typename C, typename std::enable_if<!Reservable<C>::value, int>::type = 0>
+    static void reserve(C &, size_t)
+    {
+    }
+
+    // Converts whole numeric arrays without the per item checks in one loop that the compiler can vectorize.
+    template <typename C, typename std::enable_if<std::is_same<C, std::vector<Item>>::value &&
+                                                      std::is_arithmetic<Item>::value &&
+                                                      !std::is_same<Item, bool>::value,
+                                                  int>::type = 0>
+    static bool numeric(C &output, const Array &array)
+    {
+        bool integers = true, numbers = true;
+        for (auto &item : array)
+        {
+            integers &= item._type == Type::Integer;
+            numbers &= item._type == Type::Integer || item._type == Type::Real;
+        }
+        if (!numbers) return false;
+
+        output.resize(array.size());
+        auto data = output.data();
+        if (integers)
+            for (size_t i = 0; i < array.size(); ++i) data[i] = Item(array[i]._value.i);
+        else
+            for (size_t i = 0; i < array.size(); ++i)
+                data[i] = array[i]._type == Type::Integer ? Item(array[i]._value.i) : Item(array[i]._value.r);
+        return true;
+    }
+
+    template <typename C, typename std::enable_if<!std::is_same<C, std::vector<Item>>::value ||
+                                                      !std::is_arithmetic<Item>::value ||
+                                                      std::is_same<Item, bool>::value,
+                                                  int>::type = 0>
+    static bool numeric(C &, const Array &)
+    {
+        return false;
+    }
+
+    static T get(const Value &value)
+    {
+        T output;
+        auto &array = value.array();
+        if (numeric(output, array)) return output;
+        reserve(output, array.size());
+        for (auto &item : array) output.insert(output.end(), Codec<Item>::get(item));
+        return output;
+    }
+
+    static T take(Value &&value)
+    {
+        T output;
+        auto &array = value.array();
+        if (numeric(output, array)) return output;
+        reserve(output, array.size());
+        for (auto &item : array) output.insert(output.end(), Codec<Item>::take(std::move(item)));
+        return output;
+    }
+
+    static void put(Value &value, const T &input)
+    {
+        auto &array = value.array({});
+        array.reserve(input.size());
+        for (auto &&item : input) array.emplace_back(item);
+    }
+
+    static void put(Value &value, T &&input)
+    {
+        auto &array = value.array({});
+        array.reserve(input.size());
+        for (auto &&item : input) array.emplace_back(std::move(item));
+    }
+};
+
+template <typename T>
+struct Codec<T, Kind::Map>
+{
+    typedef typename T::mapped_type Item;
+
+    static T get(const Value &value)
+    {
+        T output;
+        for (auto &pair : value.object()) output.emplace(pair.first, Codec<Item>::get(pair.second));
+        return output;
+    }
+
+    static T take(Value &&value)
+    {
+        T output;
+        for (auto &pair : value.object()) output.emplace(pair.first, Codec<Item>::take(std::move(pair.second)));
+        return output;
+    }
+
+    static void put(Value &value, const T &input)
+    {
+        auto &object = value.object({});
+        object.reserve(input.size());
+        for (auto &pair : input) object.emplace(String(pair.first), Value(pair.second));
+    }
+
+    static void put(Value &value, T &&input)
+    {
+        auto &object = value.object({});
+        object.reserve(input.size());
+        for (auto &pair : input) object.emplace(String(pair.first), Value(std::move(pair.second)));
+    }
+};
+
+template <typename T>
+struct Codec<T, Kind::Unsupported>
+{
+    static_assert(sizeof(T) == 0, "Type can't be converted to or from Value!");
+};
+}  // namespace Convert
+
+namespace IO
+{
+/// Reader of the elements of a top-level array from a stream one at a time.
+/// Only the element being parsed is kept in memory so the array can be larger than the memory.
+class Elements
+{
+    std::istream *_stream;
+    std::unique_ptr<std::ifstream> _file;
+    Policy _policy;
+    Value _value;
+    Result _result;
+    std::string _buffer;
+    size_t _begin, _scan, _depth, _offset;
+    bool _quoted, _escaped, _eof;
+    enum class State
+    {
+        Open,
+        Element,
+        Tail,
+        Done,
+    } _state;
+
+    bool fill();
+    bool skip();
+    bool stop(Error error, size_t index);
+
+public:
+    /// Input iterator over the elements that refers to the value of the reader.
+    class iterator
+    {
+        Elements *_elements;
+
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef Value value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Value *pointer;
+        typedef Value &reference;
+
+        /// Constructor that creates an iterator of the reader or the end iterator if elements is null.
+        explicit iterator(Elements *elements = nullptr) : _elements(elements) {}
+
+        /// Returns the current element.
+        inline Value &operator*() const { return _elements->_value; }
+
+        /// Returns a pointer to the current element.
+        inline Value *operator->() const { return &_elements->_value; }
+
+        /// Reads the next element and becomes the end iterator if there is none.
+        iterator &operator++()
+        {
+            if (!_elements->next(_elements->_value)) _elements = nullptr;
+            return *this;
+        }
+
+        /// Comparison operator that returns true if both iterators are at the same position.
+        inline bool operator==(const iterator &other) const { return _elements == other._elements; }
+
+        /// Comparison operator that returns false if both iterators are at the same position.
+        inline bool operator!=(const iterator &other) const { return _elements != other._elements; }
+    };
+
+    /// Constructor that reads the elements from the stream according to the policy.
+    explicit Elements(std::istream &stream, const Policy &policy = Policy());
+
+    /// Constructor that reads the elements from the file according to the policy.
+    /// If the file can't be opened the result has FileIOError.
+    explicit Elements(const std::string &path, const Policy &policy = Policy());
+
+    /// Destructor function.
+    ~Elements();
+
+    /// Reads the next element into value and returns true, returns false at the end of the array or on errors.
+    bool next(Value &value);
+
+    /// Returns the result which has the error and the stream offset where reading stopped.
+    inline const Result &result() const { return _result; }
+
+    /// Reads the first element and returns an iterator to it. Should be called once.
+    iterator begin() { return next(_value) ? iterator(this) : iterator(); }
+
+    /// Returns the end iterator.
+    iterator end() { return iterator(); }
+};
+
+/// Byte range of a document in the input.
+struct Range
+{
+    /// Offset of the first byte of the document.
+    size_t begin;
+
+    /// Offset after the last byte of the document.
+    size_t end;
+};
+
+/// Reader of successive documents from one buffer or stream. Documents can be concatenated with or without whitespace
+/// between them or framed as RFC 7464 JSON text sequences (each starting with the 0x1E record separator). Numbers and
+/// literals end at whitespace or a structural character, so 12true fails with FailedToReachEnd in both modes.
+class DocumentStream
+{
+    const char *_data;
+    size_t _size;
+    std::istream *_stream;
+    Policy _policy;
+    Result _result;
+    Range _range;
+    std::string _buffer;
+    std::vector<uint32_t> _counts;
+    size_t _begin, _scan, _depth, _offset;
+    bool _quoted, _escaped, _eof;
+
+    bool fill();
+    bool separate();
+    bool find(size_t &end);
+    bool stop(Error error, size_t index);
+
+public:
+    /// Constructor that reads the documents from the null-terminated string which should outlive the reader.
+    explicit DocumentStream(const char *data, const Policy &policy = Policy());
+
+    /// Constructor that reads the documents from the string which should outlive the reader.
+    explicit DocumentStream(const std::string &data, const Policy &policy = Policy());
+
+    /// Temporary strings are rejected because they would be destroyed before the documents are read.
+    DocumentStream(std::string &&data, const Policy &policy = Policy()) = delete;
+
+    /// Constructor that reads the documents from the stream in chunks.
+    explicit DocumentStream(std::istream &stream, const Policy &policy = Policy());
+
+    /// Reads the next document into value and returns true, returns false at the end of the input or on errors.
+    bool next(Value &value);
+
+    /// Returns the byte range of the last document that was read.
+    inline const Range &range() const { return _range; }
+
+    /// Returns the result which has the error and the offset where reading stopped.
+    inline const Result &result() const { return _result; }
+};
+
+/// Reads the elements of the top-level array in the stream one at a time into a reused value and calls the callback
+/// with each of them. Stops early if the callback returns false.
+Result forEachElement(std::istream &stream, const std::function<bool(Value &value)> &callback,
+                      const Policy &policy = Policy());
+
+/// Reads the elements of the top-level array in the file one at a time into a reused value and calls the callback
+/// with each of them. Stops early if the callback returns false.
+Result forEachElement(const std::string &path, const std::function<bool(Value &value)> &callback,
+                      const Policy &policy = Policy());
+
+/// Index of the byte ranges of the records (lines that are not blank) of an NDJSON file and optionally the values of a
+/// key of each record. It can be saved to a sidecar file next to the NDJSON file and loaded instead of being built again.
+class LineIndex
+{
+    std::vector<Range> _records;
+    std::vector<std::string> _values;
+    std::unordered_map<std::string, size_t> _lookup;
+    std::string _key;
+    uint64_t _size;
+
+public:
+    /// Constructor that creates an empty index.
+    LineIndex();
+
+    /// Builds the index of the file by scanning for newlines with the given number of threads (zero uses one thread
+    /// per core). If key is not empty each record is parsed with the threads to keep the value of the key.
+    Result build(const std::string &path, const std::string &key = std::string(), size_t threads = 0);
+
+    /// Writes the index to the sidecar file.
+    Result save(const std::string &path) const;
+
+    /// Reads the index from the sidecar file.
+    Result load(const std::string &path);
+
+    /// Returns the number of records.
+    inline size_t size() const { return _records.size(); }
+
+    /// Returns the size of the indexed file in bytes.
+    inline uint64_t bytes() const { return _size; }
+
+    /// Returns the key whose values are indexed or an empty string if there is none.
+    inline const std::string &key() const { return _key; }
+
+    /// Returns the byte range of the record at index.
+    inline const Range &range(size_t index) const { return _records[index]; }
+
+    /// Returns the index of the first record whose key has the value or size() if there is none.
+    size_t find(const Value &value) const;
+};
+
+/// Reader of individual records of an NDJSON file that uses an index and positional reads so records are fetched on
+/// demand. Readers don't share state and can be used from different threads.
+class LineReader
+{
+    const LineIndex *_index;
+    FILE *_file;
+    std::string _buffer;
+
+public:
+    /// Constructor that opens the file of the index. If the file can't be opened or its size is not the same as when
+    /// it was indexed reading fails with FileIOError.
+    LineReader(const std::string &path, const LineIndex &index);
+
+    /// Destructor function.
+    ~LineReader();
+
+    LineReader(const LineReader &) = delete;
+    LineReader &operator=(const LineReader &) = delete;
+
+    /// Reads the record at index into value according to the policy.
+    Result read(size_t index, Value &value, const Policy &policy = Policy());
+
+    /// Reads the first record whose key has the key value into value according to the policy.
+    Result find(const Value &key, Value &value, const Policy &policy = Policy());
+};
+
+/// Structural index of a JSON file which has the positions of its brackets, braces, colons, commas, quotes and
+/// the starts of the other scalars, with links between matching brackets. It can be saved to a sidecar file next to
+/// the JSON file and loaded so later queries don't scan the file again.
+class StructuralIndex
+{
+    std::vector<uint64_t> _offsets;
+    std::vector<uint64_t> _links;
+    std::string _types;
+    uint64_t _size;
+
+    bool add(char type, uint64_t offset, std::vector<size_t> &stack);
+
+public:
+    /// Constructor that creates an empty index.
+    StructuralIndex();
+
+    /// Builds the index of the file. Fails if brackets or quotes don't match or a second value starts after the first
+    /// one, the rest of the grammar is only checked when values are extracted.
+    Result build(const std::string &path);
+
+    /// Writes the index to the sidecar file.
+    Result save(const std::string &path) const;
+
+    /// Reads the index from the sidecar file.
+    Result load(const std::string &path);
+
+    /// Returns the number of structural characters.
+    inline size_t size() const { return _types.size(); }
+
+    /// Returns the size of the indexed file in bytes.
+    inline uint64_t bytes() const { return _size; }
+
+    /// Returns the byte offset of the structural character at index.
+    inline uint64_t offset(size_t index) const { return _offsets[index]; }
+
+    /// Returns the structural character at index which is one of {}[]:," or s for the start of other scalars.
+    inline char type(size_t index) const { return _types[index]; }
+
+    /// Returns the index of the matching bracket or brace of the one at index.
+    inline size_t link(size_t index) const { return size_t(_links[index]); }
+
+    /// Returns the index of the structural character after the value that starts at index.
+    size_t skip(size_t index) const;
+
+    /// Returns the byte range of the value that starts at index.
+    Range range(size_t index) const;
+};
+
+/// Reader of the values of a JSON file at JSON Pointer (RFC 6901) paths that uses a structural index to jump over
+/// values and reads only the bytes it needs with positional reads.
+class StructuralReader
+{
+    const StructuralIndex *_index;
+    FILE *_file;
+    std::string _cache, _buffer;
+    uint64_t _cached;
+
+    const char *view(uint64_t begin, uint64_t end);
+    Result key(size_t index, std::string &key);
+    Result walk(size_t index, const std::function<bool(size_t key, size_t value)> &visit);
+    Result locate(const std::string &pointer, size_t &index);
+
+public:
+    /// Constructor that opens the file of the index. If the file can't be opened or its size is not the same as when
+    /// it was indexed reading fails with FileIOError.
+    StructuralReader(const std::string &path, const StructuralIndex &index);
+
+    /// Destructor function.
+    ~StructuralReader();
+
+    StructuralReader(const StructuralReader &) = delete;
+    StructuralReader &operator=(const StructuralReader &) = delete;
+
+    /// Finds the byte range of the value at the path.
+    Result range(const std::string &pointer, Range &range);
+
+    /// Reads the value at the path into value according to the policy.
+    Result extract(const std::string &pointer, Value &value, const Policy &policy = Policy());
+
+    /// Counts the items of the array or members of the object at the path without reading them.
+    Result size(const std::string &pointer, size_t &size);
+
+    /// Reads the keys of the object at the path in their order in the file.
+    Result keys(const std::string &pointer, std::vector<std::string> &keys);
 };
+}  // namespace IO
 
 /// Operator for printing Error to standard stream
 std::ostream &operator<<(std::ostream &os, Error error);
@@ -440,6 +1583,21 @@ std::ostream &operator<<(std::ostream &os, const Result &result);
 /// Operator for printing Mode to standard stream
 std::ostream &operator<<(std::ostream &os, Mode mode);
 
+/// Operator for printing IO::Numbers to standard stream
+std::ostream &operator<<(std::ostream &os, IO::Numbers numbers);
+
+/// Operator for printing Metrics::Operation to standard stream
+std::ostream &operator<<(std::ostream &os, Metrics::Operation operation);
+
+/// Operator for printing Metrics::Size to standard stream
+std::ostream &operator<<(std::ostream &os, Metrics::Size size);
+
+/// Operator for printing Trace::Phase to standard stream
+std::ostream &operator<<(std::ostream &os, Trace::Phase phase);
+
+/// Prints the SIMD level to the output stream.
+std::ostream &operator<<(std::ostream &os, Simd::Level level);
+
 /// Operator for printing Value to standard stream
 std::ostream &operator<<(std::ostream &os, const Value &value);
 
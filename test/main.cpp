@@ -31,11 +31,28 @@
 */
 
 #include <neyson/neyson.h>
+#if __cplusplus >= 202002L
+#include <neyson/literal.h>
+#endif
 
 #include <cmath>
+#include <cstdio>
 #include <ctime>
+#include <fstream>
 #include <iostream>
+#include <list>
+#include <map>
 #include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
 
 #define CLEAR "\033[0m"
 #define RED "\033[31m"
@@ -49,6 +66,10 @@
         throw 0;                                                                                             \
     }
 
+#ifdef NEYSON_NO_EXCEPTIONS
+// The library aborts instead of throwing so the throwing paths can't be checked.
+#define THROW(expr)
+#else
 #define THROW(expr)                                                                                          \
     try                                                                                                      \
     {                                                                                                        \
@@ -59,6 +80,7 @@
     catch (...)                                                                                              \
     {                                                                                                        \
     }
+#endif
 
 #define NTHROW(expr)                                                                                         \
     try                                                                                                      \
@@ -104,6 +126,9 @@ using namespace Neyson;
 
 int Code = 0;
 
+// The process id keeps test binaries that run at the same time from overwriting each other's files.
+string temporary(const string &extension) { return "neyson_test_" + to_string(getpid()) + extension; }
+
 namespace Checker
 {
 void checkValue(const Value &value1, const Value &value2);
@@ -438,6 +463,720 @@ TEST(Random)
     }
 }
 
+TEST(Pool)
+{
+    auto before = Pool::stats();
+    {
+        Value value = Array{"test", Object{{"test", Array{10}}}};
+        Value copy = value;
+        copy = std::move(copy[1]);
+        CHECK(copy["test"][0].integer() == 10);
+    }
+
+    auto after = Pool::stats();
+    if (!Pool::enabled())
+    {
+        CHECK(after.allocations == 0);
+        return;
+    }
+
+    CHECK(after.allocations > before.allocations);
+    CHECK(after.allocations - before.allocations == after.deallocations - before.deallocations);
+    CHECK(after.used == before.used);
+
+    auto value = new Value("test");
+    thread([value]() { delete value; }).join();
+    CHECK(Pool::stats().remote == after.remote + 1);
+
+    CHECK(Pool::enable(false));
+    Value value1 = "test";
+    CHECK(!Pool::enable(true));
+    value1 = Value();
+    CHECK(Pool::stats().allocations == after.allocations + 1);
+}
+
+TEST(Stats)
+{
+    Stats stats;
+    Value value;
+    std::string data = "{\"a\": [1, 2.5, \"test\", [true, null]], \"b\": {}}";
+    CHECK(IO::read(value, data, &stats));
+    CHECK(stats.bytes == data.size());
+    CHECK(stats.values[int(Type::Null)] == 1);
+    CHECK(stats.values[int(Type::Bool)] == 1);
+    CHECK(stats.values[int(Type::Integer)] == 1);
+    CHECK(stats.values[int(Type::Real)] == 1);
+    CHECK(stats.values[int(Type::String)] == 1);
+    CHECK(stats.values[int(Type::Array)] == 2);
+    CHECK(stats.values[int(Type::Object)] == 2);
+    CHECK(stats.depth == 3);
+    CHECK(stats.string == 4);
+    CHECK(stats.array == 4);
+    CHECK(stats.object == 2);
+    CHECK(stats.allocations == 5);
+
+    CHECK(IO::write(value, data, Mode::Compact, &stats));
+    CHECK(stats.bytes == data.size());
+    CHECK(stats.depth == 3);
+    CHECK(IO::fread(value, "/nonexistent/file.json", &stats).error == Error::FileIOError);
+    CHECK(stats.bytes == 0 && stats.depth == 0 && stats.values[int(Type::Object)] == 0 && stats.io == 0);
+    CHECK(IO::write(value, data, Mode::Compact, &stats));
+    CHECK(IO::fwrite(value, "/nonexistent/file.json", Mode::Compact, &stats).error == Error::FileIOError);
+    CHECK(stats.bytes == 0 && stats.depth == 0 && stats.allocations == 0);
+}
+
+TEST(Metrics)
+{
+    Metrics::Histogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i) histogram.record(i);
+    CHECK(histogram.count == 1000);
+    CHECK(histogram.quantile(.5) >= 500 && histogram.quantile(.5) <= 500 * 1.125);
+    CHECK(histogram.max() >= 1000 && histogram.max() <= 1000 * 1.125);
+    for (uint64_t value : {0, 7, 8, 100, 12345, 1 << 20})
+        CHECK(Metrics::Histogram::upper(Metrics::Histogram::bucket(value)) >= value);
+
+    CHECK(!Metrics::enable(true));
+    Metrics::reset();
+    Value value;
+    CHECK(IO::read(value, std::string("[1, 2, 3]")));
+    CHECK(!IO::read(value, std::string("[1, 2, 3")));
+    std::string data;
+    CHECK(IO::write(value, data));
+    thread([&value]() { CHECK(IO::read(value, "{}")); }).join();
+    CHECK(Metrics::enable(false));
+
+    auto snapshot = Metrics::snapshot();
+    const auto &read = snapshot(Metrics::Operation::Read, Metrics::Size::Tiny);
+    CHECK(read.calls == 3);
+    CHECK(read.errors == 1);
+    CHECK(read.bytes == 19);
+    CHECK(read.latency.count == 3);
+    CHECK(snapshot(Metrics::Operation::Write, Metrics::Size::Tiny).calls == 1);
+    CHECK(snapshot(Metrics::Operation::FRead, Metrics::Size::Tiny).calls == 0);
+
+    auto report = Metrics::report(snapshot);
+    CHECK(report["Read"]["Tiny"]["calls"].integer() == 3);
+    CHECK(report["Write"]["Tiny"]["calls"].integer() == 1);
+    CHECK(report["FRead"].object().empty());
+
+    Metrics::reset();
+    CHECK(Metrics::snapshot()(Metrics::Operation::Read, Metrics::Size::Tiny).calls == 0);
+}
+
+TEST(Trace)
+{
+    Trace::start(1000);
+    Value value;
+    std::string data = "{\"a\": [1, 2.5, \"te\\nst\"]}";
+    CHECK(IO::read(value, data));
+    CHECK(IO::write(value, data));
+    Trace::stop();
+    CHECK(IO::read(value, data));
+
+    auto dump = Trace::dump();
+    auto &events = dump["traceEvents"].array();
+#ifndef NEYSON_USE_TRACE
+    CHECK(events.empty());
+    return;
+#endif
+
+    std::map<std::string, size_t> counts;
+    for (auto &event : events)
+    {
+        CHECK(event["ph"].string() == "X");
+        CHECK(event["dur"].real() >= 0);
+        ++counts[event["name"].string()];
+    }
+
+    CHECK(counts["Read"] == 1);
+    CHECK(counts["Build"] == 2);
+    CHECK(counts["Scan"] == 2);
+    CHECK(counts["Decode"] == 2);
+    CHECK(counts["Number"] == 2);
+    CHECK(counts["Write"] == 1);
+    CHECK(counts["Flush"] == 1);
+
+    std::string output;
+    CHECK(IO::write(dump, output));
+    CHECK(IO::read(value, output));
+}
+
+struct Budget
+{
+    Integer bytes, allocations, deallocations;
+};
+
+TEST(Memory)
+{
+    Budget budget{1000, 0, 0};
+    Memory::Hooks hooks{
+        [](void *, size_t size, Type, void *data) -> bool {
+            auto budget = static_cast<Budget *>(data);
+            if (budget->bytes < Integer(size)) return false;
+            budget->bytes -= size;
+            ++budget->allocations;
+            return true;
+        },
+        [](void *, size_t size, Type, void *data) {
+            auto budget = static_cast<Budget *>(data);
+            budget->bytes += size;
+            ++budget->deallocations;
+        },
+        &budget,
+    };
+
+    CHECK(Memory::install(&hooks) == nullptr);
+    {
+        Value value;
+        CHECK(IO::read(value, "[\"test\", {\"test\": []}]"));
+        CHECK(budget.allocations == 4);
+        Value copy = value;
+        CHECK(budget.allocations == 8);
+    }
+    CHECK(budget.deallocations == 8);
+    CHECK(budget.bytes == 1000);
+
+    {
+        Value value;
+        std::string document = "[\"a\", [1, 2], {\"b\": \"c\"}, [], {}, \"d\"]";
+        budget.bytes = Integer(sizeof(Array) * 2 + sizeof(String) + sizeof(Object));
+        auto result = IO::read(value, document);
+        CHECK(result.error == Error::AllocationRejected && document.substr(result.index, 2) == "\"c");
+        value.reset();
+        CHECK(budget.allocations == budget.deallocations);
+        CHECK(budget.bytes == Integer(sizeof(Array) * 2 + sizeof(String) + sizeof(Object)));
+        CHECK(budget.allocations == 12);
+    }
+
+#ifndef NEYSON_NO_EXCEPTIONS
+    budget.bytes = 0;
+    THROW(Value("test"));
+    Value value = 10;
+    THROW(value = Array());
+    CHECK(value.type() == Type::Null);
+    CHECK(budget.allocations == 12);
+#endif
+    CHECK(Memory::install(nullptr) == &hooks);
+    CHECK(Memory::installed() == nullptr);
+}
+
+TEST(Status)
+{
+    Value value = Object{{"integer", 10}, {"real", 2.5}, {"string", "12x"}, {"text", "text"}, {"array", Array{1}}};
+    CHECK(value.find("missing") == nullptr);
+    CHECK(value.find("integer") != nullptr);
+    CHECK(value["integer"].find("integer") == nullptr);
+    CHECK(static_cast<const Value &>(value).find("real")->real() == 2.5);
+
+    CHECK(value.objectIf() == &value.object());
+    CHECK(value.arrayIf() == nullptr);
+    CHECK(*value["integer"].integerIf() == 10);
+    CHECK(value["integer"].realIf() == nullptr);
+    CHECK(value["real"].stringIf() == nullptr);
+    CHECK(value["text"].stringIf()->size() == 4);
+    CHECK(value["array"].booleanIf() == nullptr);
+
+    bool boolean;
+    Integer integer;
+    Real real;
+    String string;
+    CHECK(value["integer"].convert(boolean) && boolean);
+    CHECK(value["real"].convert(integer) && integer == 2);
+    CHECK(value["string"].convert(integer) && integer == 12);
+    CHECK(!value["text"].convert(integer));
+    CHECK(!value["text"].convert(real));
+    CHECK(!Value("1e999999").convert(real));
+    CHECK(!Value("99999999999999999999").convert(integer));
+    CHECK(value["integer"].convert(string) && string == "10");
+    CHECK(!value["array"].convert(string));
+    CHECK(!value["array"].convert(integer));
+    CHECK(value["array"].convert(boolean) && boolean);
+}
+
+#if __cplusplus >= 202002L
+TEST(Literal)
+{
+    using namespace Neyson::Literal;
+    constexpr auto literal = R"({"a": [1, -2, 3.5e2, "x\n\u00e9"], "b": {"c": true, "d": null}, "e": 0.1})"_json;
+    static_assert(literal.size() == 3);
+    static_assert(literal["a"].size() == 4);
+    static_assert(literal["a"][1].integer() == -2);
+    static_assert(literal["a"][2].real() == 350);
+    static_assert(literal["a"][3].string() == "x\n\xC3\xA9");
+    static_assert(literal["b"]["c"].boolean());
+    static_assert(literal["b"]["d"] == Type::Null);
+    static_assert(literal["e"].real() == 0.1);
+    static_assert(literal.key(1) == "b");
+    static_assert(!literal.find("f"));
+    static_assert(literal.find("b")->find("c")->boolean());
+
+    constexpr auto numbers = R"([-9223372036854775808, 1e-320, 123456789.123456789, 1.7976931348623157e308])"_json;
+    static_assert(numbers[0].integer() == INT64_MIN);
+    static_assert(numbers[1].real() > 0 && numbers[2].real() == 123456789.123456789);
+    static_assert(numbers[3].real() == 1.7976931348623157e308);
+
+    Value value;
+    CHECK(IO::read(value, R"({"a": [1, -2, 3.5e2, "x\n\u00e9"], "b": {"c": true, "d": null}, "e": 0.1})"));
+    NTHROW(Checker::check(literal.value(), value));
+    CHECK(R"("")"_json.string().empty());
+    CHECK(R"([])"_json.value().array().empty());
+    THROW(literal["f"]);
+    THROW(literal["a"].string());
+}
+#endif
+
+TEST(Simd)
+{
+    auto initial = Simd::level();
+    CHECK(Simd::supported() >= initial);
+    CHECK(Simd::select(Simd::Level::AVX512) == Simd::supported());
+
+    std::vector<Value> values;
+    std::vector<std::string> inputs = {
+        " \t\r\n [ 1 , -12 , 123456789012345678 , 1234567890123456789 , 1.5e3 , \"\" ] \n ",
+        "\"unterminated\\", "\"unterminated", "[1, 2", "-", "{\"a\\\"b\": \"c\\\\\"}",
+    };
+    for (size_t i = 0; i < 200; ++i) values.push_back(Random::random());
+    for (size_t i = 0; i < 130; ++i)
+    {
+        std::string text(i, 'x');
+        for (auto special : {'\"', '\\', '/', '\n', '\x01', '\0'})
+            values.push_back(text + special + text), inputs.push_back(std::string(i, ' ') + "\"" + text + "\\\"\"");
+        values.push_back(text + "\xC3\xA9" + text);
+    }
+
+    std::vector<std::string> expected;
+    std::vector<Result> results;
+    for (auto level : {Simd::Level::Scalar, Simd::Level::SSE42, Simd::Level::AVX2, Simd::Level::AVX512})
+    {
+        if (level > Simd::supported()) break;
+        CHECK(Simd::select(level) == level);
+        CHECK(Simd::level() == level);
+
+        std::vector<std::string> outputs;
+        std::vector<Result> parsed;
+        for (const auto &value : values)
+        {
+            String data;
+            Value copy;
+            CHECK(IO::write(value, data));
+            CHECK(IO::read(copy, data));
+            NTHROW(Checker::check(copy, value));
+            outputs.push_back(data);
+        }
+        for (const auto &input : inputs)
+        {
+            Value value;
+            String data;
+            parsed.push_back(IO::read(value, input));
+            CHECK(IO::write(value, data));
+            outputs.push_back(data);
+        }
+
+        if (level == Simd::Level::Scalar) expected = outputs, results = parsed;
+        CHECK(outputs == expected);
+        for (size_t i = 0; i < parsed.size(); ++i)
+            CHECK(parsed[i].error == results[i].error && parsed[i].index == results[i].index);
+
+        CHECK(Simd::validate("", 0));
+        CHECK(Simd::validate("plain ascii text that is longer than a single vector of sixty four bytes!!", 73));
+        CHECK(Simd::validate("\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80", 9));
+        CHECK(!Simd::validate("\xC3", 1));
+        CHECK(!Simd::validate("\xC0\xAF", 2));
+        CHECK(!Simd::validate("\xED\xA0\x80", 3));
+        CHECK(!Simd::validate("\xF4\x90\x80\x80", 4));
+        CHECK(!Simd::validate("\x80", 1));
+    }
+    Simd::select(initial);
+}
+
+TEST(Policy)
+{
+    Value value;
+    IO::Policy lenient, strict = IO::Policy::strict(), integer(IO::Numbers::Integer);
+    CHECK(IO::read(value, "+1", lenient).error == Error::None);
+    CHECK(IO::read(value, "+1", strict).error == Error::UnexpectedValueStart);
+    CHECK(IO::read(value, ".5", strict).error == Error::UnexpectedValueStart);
+    CHECK(IO::read(value, "01", strict).error == Error::InvalidNumber);
+    CHECK(IO::read(value, "1.", strict).error == Error::InvalidNumber);
+    CHECK(IO::read(value, "1e", strict).error == Error::InvalidNumber);
+    CHECK(IO::read(value, "-0.5e+3", strict).error == Error::None && value.real() == -500);
+    CHECK(IO::read(value, "[-12,0]", integer).error == Error::None && value[0].integer() == -12);
+    CHECK(IO::read(value, "1.5", integer).error == Error::InvalidNumber);
+    CHECK(IO::read(value, "1e3", integer).error == Error::InvalidNumber);
+
+    std::string duplicate = "{\"a\":1,\"a\":2}";
+    CHECK(IO::read(value, duplicate, lenient).error == Error::None && value["a"].integer() == 1);
+    auto result = IO::read(value, duplicate, strict);
+    CHECK(result.error == Error::DuplicateKey && result.index == 7);
+
+    std::string invalid = "[\"\xC3\x28\"]";
+    CHECK(IO::read(value, invalid, lenient).error == Error::None);
+    CHECK(IO::read(value, invalid, strict).error == Error::InvalidEncoding);
+    CHECK(IO::read(value, "{\"\xC3\xA9\":\"\xE2\x82\xAC\"}", strict).error == Error::None);
+
+    IO::Policy shallow(IO::Numbers::Lenient, true, false, 2);
+    CHECK(IO::read(value, "[{}]", shallow).error == Error::None);
+    CHECK(IO::read(value, "[{},[]]", shallow).error == Error::None);
+    CHECK(IO::read(value, "[[[]]]", shallow).error == Error::DepthExceeded);
+    CHECK(IO::read(value, std::string(100000, '[') + std::string(100000, ']'), strict).error == Error::DepthExceeded);
+
+    IO::Policy reserve;
+    reserve.reserve = true;
+    std::string document = "[{\"a\":[1,2,3],\"b,]\":\"[\\\"]\",\"c\":{}},[],[[null, true],\"x\"]]";
+    Value expected;
+    CHECK(IO::read(expected, document).error == Error::None);
+    CHECK(IO::read(value, document, reserve).error == Error::None);
+    NTHROW(Checker::check(value, expected));
+    CHECK(value.array().capacity() == 3 && value[0]["a"].array().capacity() == 3);
+    CHECK(value[1].array().capacity() == 0 && value[2][0].array().capacity() == 2);
+    for (auto invalid : {"[1,,2]", "[{\"a\":]", "[\"\\", "]]", "{,}", "[[[\"a\"", ",[1]"})
+        CHECK(IO::read(value, invalid, reserve).error == IO::read(expected, invalid).error);
+}
+
+TEST(Convert)
+{
+    Value value = std::vector<int>{1, 2, 3};
+    CHECK(value == Type::Array && value[2].integer() == 3);
+    CHECK(value.as<std::vector<double>>() == std::vector<double>({1, 2, 3}));
+    CHECK(Value(Array{1, 2.5}).as<std::vector<double>>() == std::vector<double>({1, 2.5}));
+    CHECK(Value(Array{1, "2"}).as<std::vector<int>>() == std::vector<int>({1, 2}));
+    CHECK(Value(Array{1, 0}).as<std::vector<bool>>() == std::vector<bool>({true, false}));
+    std::vector<bool> booleans = {true, false};
+    CHECK(Value(booleans)[0] == Type::Bool && Value(booleans)[1].boolean() == false);
+    CHECK(Value(std::vector<bool>{true}).as<std::vector<bool>>() == std::vector<bool>({true}));
+    CHECK(value.as<std::list<long>>() == std::list<long>({1, 2, 3}));
+    CHECK(value.as<std::set<int>>().count(2) == 1);
+    CHECK(value.as<std::vector<Value>>()[0] == Type::Integer);
+
+    std::vector<std::string> strings = {std::string(100, 'a'), "b"};
+    value = strings;
+    CHECK(value[0].string() == strings[0]);
+    auto data = value[0].string().data();
+    auto moved = std::move(value).as<std::vector<std::string>>();
+    CHECK(moved == strings && moved[0].data() == data);
+
+    typedef std::map<std::string, std::vector<int>> Map;
+    Map map = {{"a", {1}}, {"b", {2, 3}}};
+    value = map;
+    CHECK(value["b"][1].integer() == 3);
+    CHECK(value.as<Map>() == map);
+    auto unordered = value.as<std::unordered_map<std::string, Value>>();
+    CHECK(unordered["a"][0].integer() == 1);
+    CHECK(Value(2.5).as<int>() == 2 && Value("3").as<double>() == 3 && Value(1).as<std::string>() == "1");
+
+    Value nested = std::vector<std::vector<std::string>>{{"x"}, {"y", "z"}};
+    CHECK(nested[1][1].string() == "z");
+    THROW(Value(1).as<std::vector<int>>());
+    THROW(Value(Array{1}).as<Map>());
+}
+
+TEST(Emplace)
+{
+    Value value;
+    value.emplace_back(1);
+    value.emplace_back("text");
+    value.emplace_back(std::string(100, 'a'));
+    value.emplace_back().emplace("key", 2.5);
+    CHECK(value.array().size() == 4 && value[1].string() == "text" && value[3]["key"].real() == 2.5);
+    CHECK(&value.emplace_back() == &value.array().back());
+    value.reserve(100);
+    CHECK(value.array().capacity() >= 100);
+
+    Value object;
+    CHECK(object.emplace("a", 1).integer() == 1);
+    CHECK(object.emplace(std::string("a"), 2).integer() == 1);
+    object.emplace("b", Array{1, 2});
+    object.reserve(64);
+    CHECK(object.object().size() == 2 && object["b"][1].integer() == 2);
+    THROW(Value(1).emplace_back(1));
+    THROW(Value(Array{}).emplace("a", 1));
+    THROW(Value(true).reserve(1));
+
+    Value built = Build::object({
+        {"id", 10},
+        {"name", "neyson"},
+        {"tags", Build::array({"json", 1, 2.5, true, Value()})},
+        {"nested", Build::object({{"empty", Build::array({})}})},
+        {"id", 20},
+    });
+    CHECK(built.object().size() == 4 && built["id"].integer() == 10 && built["name"].string() == "neyson");
+    CHECK(built["tags"].array().capacity() == 5 && built["tags"][4] == Type::Null);
+    CHECK(built["nested"]["empty"] == Type::Array);
+
+    String string(100, 'b');
+    auto data = string.data();
+    Value holder;
+    CHECK(holder.string(std::move(string)).data() == data);
+    CHECK(holder.boolean(true) && holder == Type::Bool);
+}
+
+TEST(Elements)
+{
+    std::string data = " [ {\"a\": [1, \"],\\\"\"]}, 2 ,\"x\" ,[[]], null ] \n";
+    std::istringstream stream(data);
+    std::vector<std::string> items;
+    auto result = IO::forEachElement(stream, [&](Value &value) {
+        std::string item;
+        IO::write(value, item);
+        items.push_back(item);
+        return true;
+    });
+    CHECK(result.error == Error::None && result.index == data.size());
+    CHECK(items == std::vector<std::string>({"{\"a\":[1,\"],\\\"\"]}", "2", "\"x\"", "[[]]", "null"}));
+
+    std::string large = "[";
+    for (int i = 0; i < 100000; ++i) large.append(i == 0 ? "" : ",").append("{\"id\":").append(std::to_string(i)) += "}";
+    large += "]";
+    stream.clear(), stream.str(large);
+    IO::Elements elements(stream);
+    Integer sum = 0, count = 0;
+    for (auto &item : elements) sum += item["id"].integer(), ++count;
+    CHECK(elements.result().error == Error::None && count == 100000 && sum == Integer(99999) * 100000 / 2);
+
+    count = 0;
+    stream.clear(), stream.str(large);
+    result = IO::forEachElement(stream, [&](Value &) { return ++count < 10; });
+    CHECK(result.error == Error::None && count == 10);
+
+    auto error = [](const std::string &data) {
+        std::istringstream stream(data);
+        return IO::forEachElement(stream, [](Value &) { return true; });
+    };
+    CHECK(error("[]").error == Error::None);
+    CHECK(error("").error == Error::ExpectedBracketOpen);
+    CHECK(error("{}").error == Error::ExpectedBracketOpen);
+    CHECK(error("[1,2").error == Error::ExpectedCommaOrBracketClose);
+    CHECK(error("[1,]").error == Error::ExpectedStart);
+    CHECK(error("[1 2]").error == Error::ExpectedCommaOrBracketClose);
+    CHECK(error("[1, x]").index == 4);
+    CHECK(error("[1] 2").error == Error::FailedToReachEnd);
+    CHECK(IO::forEachElement("/nonexistent/file.json", [](Value &) { return true; }).error == Error::FileIOError);
+}
+
+TEST(DocumentStream)
+{
+    auto documents = [](IO::DocumentStream &&stream) {
+        std::vector<std::string> items;
+        Value value;
+        while (stream.next(value))
+        {
+            std::string item;
+            IO::write(value, item);
+            items.push_back(item + "@" + std::to_string(stream.range().begin) + ":" + std::to_string(stream.range().end));
+        }
+        if (!stream.result())
+            items.push_back(std::to_string(int(stream.result().error)) + "@" + std::to_string(stream.result().index));
+        return items;
+    };
+
+    std::string data = "{\"a\":[1]}[2]\"x\\\"}\" 12 true\n\x1E{}\n\x1Enull\n";
+    std::vector<std::string> expected = {"{\"a\":[1]}@0:9", "[2]@9:12", "\"x\\\"}\"@12:18", "12@19:21", "true@22:26",
+                                         "{}@28:30", "null@32:36"};
+    CHECK(documents(IO::DocumentStream(data)) == expected);
+    CHECK(documents(IO::DocumentStream(data.c_str())) == expected);
+    std::istringstream stream(data);
+    CHECK(documents(IO::DocumentStream(stream)) == expected);
+
+    std::string large;
+    for (int i = 0; i < 20000; ++i) large += "{\"id\":" + std::to_string(i) + ",\"text\":\"" + std::string(i % 50, 'x') + "\"} ";
+    stream.clear(), stream.str(large);
+    IO::DocumentStream streamed(stream), buffered(large);
+    Value first, second;
+    size_t count = 0;
+    while (streamed.next(first) && buffered.next(second))
+    {
+        CHECK(first["id"].integer() == Integer(count) && second["id"].integer() == Integer(count));
+        CHECK(streamed.range().begin == buffered.range().begin && streamed.range().end == buffered.range().end);
+        ++count;
+    }
+    CHECK(count == 20000 && streamed.result() && buffered.result());
+
+    for (auto input : {"{} [1,", "1 ]", "{\"a\" 1}", "[] \"x", "12true", "nulltrue", "1\"x\""})
+    {
+        std::istringstream stream(input);
+        CHECK(documents(IO::DocumentStream(stream)) == documents(IO::DocumentStream(input)));
+    }
+    for (auto invalid : {"{} [1,", "1 ]", "{\"a\" 1}", "[] \"x", "12true", "nulltrue"})
+    {
+        IO::DocumentStream stream(invalid);
+        Value value;
+        while (stream.next(value)) continue;
+        CHECK(!stream.result());
+    }
+    CHECK(documents(IO::DocumentStream("12true")) == std::vector<std::string>({std::to_string(int(Error::FailedToReachEnd)) + "@2"}));
+    CHECK(documents(IO::DocumentStream("1\"x\"")) == std::vector<std::string>({"1@0:1", "\"x\"@1:4"}));
+    CHECK(documents(IO::DocumentStream("")).empty());
+    CHECK((!std::is_constructible<IO::DocumentStream, std::string>::value));
+    CHECK((std::is_constructible<IO::DocumentStream, std::string &>::value));
+}
+
+TEST(LineIndex)
+{
+    std::string path = temporary(".ndjson"), sidecar = path + ".lines";
+    {
+        std::ofstream stream(path, std::ios::binary);
+        for (int i = 0; i < 50000; ++i)
+        {
+            stream << "{\"id\":" << i * 7 << ",\"name\":\"record " << i << "\",\"text\":\"" << std::string(i % 100, 'x') << "\"}\n";
+            if (i % 1000 == 0) stream << (i % 2000 == 0 ? "\n" : " \t\r\n");
+        }
+        stream << "{\"name\":\"last\"}";
+    }
+
+    IO::LineIndex index, threaded, loaded;
+    CHECK(index.build(path, "", 1));
+    CHECK(index.size() == 50001);
+    CHECK(threaded.build(path, "id", 4));
+    CHECK(threaded.size() == 50001 && threaded.key() == "id");
+    for (size_t i = 0; i < index.size(); ++i)
+        if (index.range(i).begin != threaded.range(i).begin || index.range(i).end != threaded.range(i).end)
+        {
+            CHECK(false);
+            break;
+        }
+
+    Value value;
+    IO::LineReader reader(path, threaded);
+    CHECK(reader.read(12345, value) && value["name"].string() == "record 12345");
+    CHECK(reader.read(50000, value) && value["name"].string() == "last");
+    CHECK(reader.find(Value(700), value) && value["name"].string() == "record 100");
+    CHECK(reader.find(Value(701), value).error == Error::RecordNotFound);
+    CHECK(reader.read(50001, value).error == Error::RecordNotFound);
+
+    CHECK(threaded.save(sidecar));
+    CHECK(loaded.load(sidecar));
+    CHECK(loaded.size() == threaded.size() && loaded.key() == "id" && loaded.find(Value(7 * 49999)) == 49999);
+    IO::LineReader other(path, loaded);
+    CHECK(other.read(3, value) && value["id"].integer() == 21);
+
+    {
+        std::ofstream stream(path, std::ios::binary | std::ios::app);
+        stream << "\n{}";
+    }
+    CHECK(IO::LineReader(path, loaded).read(0, value).error == Error::FileIOError);
+    {
+        std::ofstream stream(sidecar, std::ios::binary);
+        stream << "NEYSONLI garbage";
+    }
+    CHECK(loaded.load(sidecar).error == Error::FileIOError && loaded.size() == 0);
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "{\"id\":1}\r\n\r\n{\"id\":2}\r\n  \r\n";
+    }
+    CHECK(index.build(path, "id") && index.size() == 2 && index.find(Value(2)) == 1);
+    CHECK(index.build(path) && index.size() == 2);
+    CHECK(IO::LineReader(path, index).read(1, value) && value["id"].integer() == 2);
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "{\"id\":1}\n{\"id\":}\n";
+    }
+    auto result = index.build(path, "id");
+    CHECK(result.error == Error::UnexpectedValueStart && result.index == 15);
+    CHECK(index.build("/nonexistent/file.ndjson").error == Error::FileIOError);
+    std::remove(path.c_str());
+    std::remove(sidecar.c_str());
+}
+
+TEST(StructuralIndex)
+{
+    std::string path = temporary(".json"), sidecar = path + ".structure";
+    std::string document = "{\"users\": [{\"id\": 1, \"name\": \"a\\\"}\"}, {\"id\": 2, \"tags\": [\"x\", \"y\"]}],"
+                           " \"a/b\": {\"m~n\": 12.5, \"e\\u0073c\": true}, \"big\": [";
+    for (int i = 0; i < 100000; ++i) document += (i == 0 ? "" : ", ") + std::to_string(i);
+    document += "], \"blob\": \"";
+    for (int i = 0; i < 400000; ++i) document += "ab\\\"";
+    document += "\", \"last\": null}";
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << document;
+    }
+
+    IO::StructuralIndex index, loaded;
+    CHECK(index.build(path));
+    CHECK(index.type(0) == '{' && index.link(0) == index.size() - 1 && index.type(index.size() - 1) == '}');
+    auto saved = index.save(sidecar);
+    CHECK(saved && saved.index < 32 + index.size() * 3 && loaded.load(sidecar) && loaded.size() == index.size());
+    CHECK(loaded.offset(index.size() - 1) == index.offset(index.size() - 1) && loaded.link(0) == index.link(0));
+
+    Value value;
+    size_t size = 0;
+    std::vector<std::string> keys;
+    IO::StructuralReader reader(path, loaded);
+    CHECK(reader.extract("/users/0/name", value) && value.string() == "a\"}");
+    CHECK(reader.extract("/users/1/tags/1", value) && value.string() == "y");
+    CHECK(reader.extract("/a~1b/m~0n", value) && value.real() == 12.5);
+    CHECK(reader.extract("/a~1b/esc", value) && value.boolean());
+    CHECK(reader.extract("/big/99999", value) && value.integer() == 99999);
+    CHECK(reader.extract("/last", value) && value == Type::Null);
+    CHECK(reader.extract("/blob", value) && value.string().size() == 1200000);
+    CHECK(reader.extract("/users/1", value) && value["tags"].array().size() == 2);
+    CHECK(reader.extract("", value) && value["big"].array().size() == 100000);
+    CHECK(reader.size("/big", size) && size == 100000);
+    CHECK(reader.size("/users/1", size) && size == 2);
+    CHECK(reader.keys("", keys) && keys == std::vector<std::string>({"users", "a/b", "big", "blob", "last"}));
+    CHECK(reader.keys("/a~1b", keys) && keys == std::vector<std::string>({"m~n", "esc"}));
+
+    IO::Range range;
+    CHECK(reader.range("/users/0/id", range) && document.substr(range.begin, range.end - range.begin) == "1");
+    CHECK(reader.extract("/users/2", value).error == Error::PathNotFound);
+    CHECK(reader.extract("/users/01", value).error == Error::PathNotFound);
+    CHECK(reader.extract("/missing", value).error == Error::PathNotFound);
+    CHECK(reader.extract("/last/x", value).error == Error::PathNotFound);
+    CHECK(reader.extract("users", value).error == Error::PathNotFound);
+    CHECK(reader.size("/last", size).error == Error::InvalidValueType);
+    CHECK(reader.keys("/big", keys).error == Error::InvalidValueType);
+
+    auto check = [&](const std::string &data, const std::string &pointer) {
+        {
+            std::ofstream stream(path, std::ios::binary);
+            stream << data;
+        }
+        IO::StructuralIndex index;
+        auto result = index.build(path);
+        if (!result) return result.error;
+        IO::StructuralReader reader(path, index);
+        Value value;
+        return reader.extract(pointer, value).error;
+    };
+    CHECK(check("[1, [2, 3]", "/0") == Error::ExpectedBracketClose);
+    CHECK(check("{\"a\": [}", "/a") == Error::ExpectedBracketClose);
+    CHECK(check("[\"a]", "/0") == Error::ExpectedQuoteClose);
+    CHECK(check("[1 2]", "/1") == Error::ExpectedCommaOrBracketClose);
+    CHECK(check("{\"a\" 1}", "/a") == Error::ExpectedColon);
+    CHECK(check("[1,,2]", "/2") == Error::UnexpectedValueStart);
+    CHECK(check("{\"a\":1} {\"b\":2}", "") == Error::FailedToReachEnd);
+    CHECK(check("1 2", "") == Error::FailedToReachEnd);
+    CHECK(check("1,2", "") == Error::FailedToReachEnd);
+    CHECK(check("\"a\"1", "") == Error::FailedToReachEnd);
+    CHECK(check(" 12 \n", "") == Error::None);
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "{\"a\tb\": 1}";
+    }
+    CHECK(index.build(path) && IO::StructuralReader(path, index).keys("", keys).error == Error::InvalidString);
+    CHECK(check("\"text\"", "") == Error::None);
+    CHECK(IO::StructuralReader(path, loaded).extract("", value).error == Error::FileIOError);
+
+    {
+        std::ofstream stream(sidecar, std::ios::binary);
+        stream << "NEYSONSI broken";
+    }
+    CHECK(loaded.load(sidecar).error == Error::FileIOError && loaded.size() == 0);
+    {
+        // The index of "1 2" which has two values at the top level.
+        uint64_t header[] = {2, 3, 2};
+        std::ofstream stream(sidecar, std::ios::binary);
+        stream << "NEYSONSI";
+        stream.write(reinterpret_cast<const char *>(header), sizeof(header));
+        stream << "ss" << char(0) << char(2);
+    }
+    CHECK(loaded.load(sidecar).error == Error::FileIOError && loaded.size() == 0);
+    CHECK(index.build("/nonexistent/file.json").error == Error::FileIOError);
+    std::remove(path.c_str());
+    std::remove(sidecar.c_str());
+}
+
 int main()
 {
     srand(static_cast<unsigned int>(time(nullptr)));
@@ -447,6 +1186,23 @@ int main()
     WriteTest();
     UnicodeTest();
     RandomTest();
+    PoolTest();
+    StatsTest();
+    MetricsTest();
+    TraceTest();
+    MemoryTest();
+    StatusTest();
+#if __cplusplus >= 202002L
+    LiteralTest();
+#endif
+    SimdTest();
+    PolicyTest();
+    ConvertTest();
+    EmplaceTest();
+    ElementsTest();
+    DocumentStreamTest();
+    LineIndexTest();
+    StructuralIndexTest();
     cout << "Tests Done!" << endl << SEPARATOR;
     return Code;
 }